@@ -0,0 +1,282 @@
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <cerrno>
+#include <libsockpp/coro.h>
+
+// co_await is kept out of if and loop conditions: GCC 12 compiles such a
+// coroutine with a spurious suspension ahead of its body.
+
+sockpp::Reactor::Reactor(void) {
+  if ((epfd = ::epoll_create1(EPOLL_CLOEXEC)) < 0)
+    throw std::runtime_error("Unable to init reactor");
+}
+
+sockpp::Reactor::~Reactor(void) {
+  // Suspended coroutines are destroyed with the tasks awaiting them
+  TASKS.clear();
+  ::close(epfd);
+}
+
+// Interest is one-shot, rearmed for the directions still awaited
+void sockpp::Reactor::arm(const int FD) {
+  const auto it { FDS.find(FD) };
+  if (it == FDS.end())
+    return;
+  else if (!it->second.in && !it->second.out) {
+    FDS.erase(it);
+    return;
+  }
+
+  struct ::epoll_event ev { };
+  ev.events = EPOLLONESHOT | (it->second.in ? EPOLLIN : 0) | (it->second.out ? EPOLLOUT : 0);
+  ev.data.fd = FD;
+  // A descriptor closed since is no longer registered
+  if (::epoll_ctl(epfd, EPOLL_CTL_MOD, FD, &ev) < 0 && errno == ENOENT)
+    ::epoll_ctl(epfd, EPOLL_CTL_ADD, FD, &ev);
+}
+
+void sockpp::Reactor::wake(std::optional<Waiter> &w, const bool OK, std::vector<std::coroutine_handle<>> &R) {
+  *w->ok = OK;
+  if (w->t != TIMERS.end())
+    TIMERS.erase(w->t);
+  R.emplace_back(w->h);
+  w.reset();
+}
+
+void sockpp::Reactor::watch(const int FD, const bool OUT, const unsigned TOMS, std::coroutine_handle<> h, bool *ok) {
+  auto &w { OUT ? FDS[FD].out : FDS[FD].in };
+  w = Waiter { h, ok, TOMS ?
+    TIMERS.emplace(Time { }.now() + std::chrono::milliseconds(TOMS), std::make_pair(FD, OUT)) :
+      TIMERS.end() };
+  arm(FD);
+}
+
+// The task runs until it first suspends
+void sockpp::Reactor::spawn(Task<> &&task) {
+  TASKS.emplace_back(std::move(task));
+  TASKS.back().start();
+}
+
+void sockpp::Reactor::run(void) {
+  std::array<struct ::epoll_event, MAXEV> events;
+  std::vector<std::coroutine_handle<>> R;
+  quit = false;
+  while (!quit && TASKS.size()) {
+    Time time;
+    // Wake at least every 10ms to observe exit()
+    int T { 10 };
+    if (TIMERS.size())
+      T = std::clamp<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        TIMERS.begin()->first - time.now()).count() + 1, 0, T);
+
+    const auto N { ::epoll_wait(epfd, events.data(), events.size(), T) };
+    for (auto i { 0 }; i < N; i++) {
+      const auto FD { events[i].data.fd };
+      const auto EV { events[i].events };
+      const auto it { FDS.find(FD) };
+      if (it == FDS.end())
+        continue;
+      if (it->second.in && (EV & (EPOLLIN | EPOLLERR | EPOLLHUP)))
+        wake(it->second.in, true, R);
+      if (it->second.out && (EV & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+        wake(it->second.out, true, R);
+      arm(FD);
+    }
+
+    for (const auto NOW { time.now() }; TIMERS.size() && TIMERS.begin()->first <= NOW;) {
+      const auto [FD, OUT] { TIMERS.begin()->second };
+      auto &w { FDS[FD] };
+      wake(OUT ? w.out : w.in, false, R);
+      arm(FD);
+    }
+
+    for (auto h : R)
+      h.resume();
+    R.clear();
+    // Retire completed tasks, passing on their exceptions
+    for (auto it { TASKS.begin() }; it != TASKS.end();)
+      if (it->done()) {
+        auto task { std::move(*it) };
+        it = TASKS.erase(it);
+        task.get();
+      } else
+          it++;
+  }
+}
+
+// Data held by the connexion, else received once the socket is readable
+sockpp::Task<std::string_view> sockpp::Async::peek(Reactor &r, Http &s, const unsigned TOMS) {
+  Time time;
+  const auto INITTIME { time.now() };
+  for (std::size_t elapsed { }; (elapsed = time.diffpt<std::chrono::milliseconds>(time.now(), INITTIME)) < TOMS;) {
+    if (const auto P { s.peek(0) }; P.size())
+      co_return P;
+    else if (s.iseof())
+      break;
+    else if (const bool READY { co_await r.readable(s.get_fd(), TOMS - elapsed) }; !READY)
+      break;
+  }
+
+  co_return std::string_view { };
+}
+
+sockpp::Task<bool> sockpp::Async::write(Reactor &r, Http &s, const std::string P, const unsigned TOMS) {
+  if (!s.queue(P))
+    co_return false;
+  while (s.flush() && s.pending())
+    if (const bool READY { co_await r.writable(s.get_fd(), TOMS) }; !READY)
+      co_return false;
+  co_return !s.pending();
+}
+
+sockpp::Task<bool> sockpp::Async::reqhdr(Reactor &r, Http &s, Header &hdr, const unsigned TOMS) {
+  while (!hdr.complete()) {
+    const auto P { co_await peek(r, s, TOMS) };
+    if (P.empty())
+      co_return false;
+    s.consume(hdr.feed(P));
+  }
+
+  co_return true;
+}
+
+sockpp::Task<bool> sockpp::Async::reqbody(Reactor &r, Http &s, const Client_span_cb &CB, std::size_t l, const unsigned TOMS) {
+  while (l) {
+    const auto P { (co_await peek(r, s, TOMS)).substr(0, l) };
+    if (P.empty())
+      co_return false;
+    CB(P);
+    s.consume(P.size());
+    l -= P.size();
+  }
+
+  co_return true;
+}
+
+// Line up to LF, CR retained
+static sockpp::Task<bool> getline(sockpp::Reactor &r, sockpp::Http &s, std::string &line, const unsigned TOMS) {
+  line.clear();
+  while (1) {
+    const auto P { co_await sockpp::Async::peek(r, s, TOMS) };
+    if (P.empty())
+      co_return false;
+    const auto *const LF { sockpp::scan(P.data(), P.data() + P.size(), '\n') };
+    line.append(P.data(), LF);
+    s.consume(LF - P.data() + (LF < P.data() + P.size()));
+    if (LF < P.data() + P.size())
+      co_return true;
+  }
+}
+
+sockpp::Task<bool> sockpp::Async::reqchkd(Reactor &r, Http &s, const Client_span_cb &CB, const unsigned TOMS) {
+  std::string line;
+  std::size_t L { };
+  while (1) {
+    if (const bool OK { co_await getline(r, s, line, TOMS) }; !OK)
+      co_return false;
+    else if (line.empty() || line == "\r")
+      // CRLF trailing the previous chunk
+      continue;
+    else if (!parsehex(line, L))
+      co_return false;
+    else if (!L)
+      break;
+    else if (const bool OK { co_await reqbody(r, s, CB, L, TOMS) }; !OK)
+      co_return false;
+  }
+
+  // Trailer up to the empty line
+  while (1)
+    if (const bool OK { co_await getline(r, s, line, TOMS) }; !OK)
+      co_return false;
+    else if (line.empty() || line == "\r")
+      co_return true;
+}
+
+sockpp::Task<bool> sockpp::Async::performreq(Reactor &r, Http &s, const std::string &HOST, Handle::Xfr &h, const unsigned TOMS) {
+  const auto REQUEST { Send<Http> { }.str(HOST, h.req()) };
+  if (REQUEST.empty())
+    co_return false;
+  else if (const bool OK { co_await write(r, s, REQUEST, TOMS) }; !OK)
+    co_return false;
+
+  h.setres();
+  Response res;
+  while (!res.done()) {
+    const auto P { co_await peek(r, s, TOMS) };
+    if (P.empty())
+      co_return false;
+    s.consume(res.feed(h, P));
+  }
+
+  co_return !res.fail();
+}
+
+template<>
+sockpp::CoServer<sockpp::Http>::CoServer(Reactor &reactor, const char PORT[], const char [], const char []) : 
+  reactor { reactor } {
+  if (!sock.Http::init_server(PORT) || !sock.set_nonblock(true))
+    throw std::runtime_error("Unable to init server");
+}
+
+template<>
+sockpp::CoServer<sockpp::Https>::CoServer(Reactor &reactor, const char PORT[], const char CERT[], const char KEY[]) : 
+  reactor { reactor } {
+  if (!(ctx = Https::server_ctx(CERT, KEY)))
+    throw std::runtime_error("Unable to load certificate");
+  else if (!sock.Http::init_server(PORT) || !sock.set_nonblock(true)) {
+    ::SSL_CTX_free(ctx);
+    throw std::runtime_error("Unable to init server");
+  }
+}
+
+template<typename S>
+sockpp::CoServer<S>::~CoServer(void) {
+  if (ctx)
+    ::SSL_CTX_free(ctx);
+}
+
+template<typename S>
+void sockpp::CoServer<S>::run(const Server_co<S> &CB) {
+  cb = CB;
+  quit = false;
+  reactor.spawn(listen());
+  reactor.run();
+}
+
+template<typename S>
+sockpp::Task<> sockpp::CoServer<S>::listen(void) {
+  while (!quit)
+    if (const bool READY { co_await reactor.readable(sock.get_fd(), 100) }; READY)
+      for (int FD; (FD = ::accept4(sock.get_fd(), nullptr, nullptr, SOCK_NONBLOCK)) > -1;)
+        reactor.spawn(serve(std::make_unique<S>(FD)));
+}
+
+template<typename S>
+sockpp::Task<> sockpp::CoServer<S>::serve(std::unique_ptr<S> server) {
+  if constexpr (std::is_same_v<S, Https>) {
+    // Handshake advanced as the socket admits, within HANDSHAKE_TOMS
+    if (!server->init(ctx))
+      co_return;
+    server->set_accept_state();
+    if (!server->set_fd(server->get_fd()))
+      co_return;
+    for (auto hs { server->handshake() }; hs != HS::DONE; hs = server->handshake())
+      if (hs == HS::FAIL)
+        co_return;
+      else if (const bool READY { co_await (hs == HS::WANTR ?
+          reactor.readable(server->get_fd(), HANDSHAKE_TOMS) :
+            reactor.writable(server->get_fd(), HANDSHAKE_TOMS)) }; !READY)
+        co_return;
+    if (!server->init_rwbio())
+      co_return;
+  }
+
+  server->init_poll();
+  // Requests held in the connexion buffer raise no further events
+  while (!quit)
+    if (const bool READY { server->buffered() || co_await reactor.readable(server->get_fd()) }; !READY)
+      break;
+    else if (const bool OK { co_await cb(*server) }; !OK)
+      break;
+}
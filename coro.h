@@ -0,0 +1,164 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <map>
+#include "sock.h"
+
+namespace sockpp {
+  template<typename T = void>
+  class Task;
+
+  namespace detail {
+    struct PromiseBase {
+      std::coroutine_handle<> cont;
+      std::exception_ptr exc;
+      // Resume the awaiting coroutine on completion
+      struct Final {
+        bool await_ready(void) noexcept { return false; }
+        template<typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+          return h.promise().cont ? h.promise().cont : std::noop_coroutine(); }
+        void await_resume(void) noexcept { }
+      };
+      std::suspend_always initial_suspend(void) noexcept { return { }; }
+      Final final_suspend(void) noexcept { return { }; }
+      void unhandled_exception(void) { exc = std::current_exception(); }
+    };
+
+    template<typename T>
+    struct Promise : PromiseBase {
+      T value { };
+      void return_value(T v) { value = std::move(v); }
+      T result(void) {
+        if (exc) std::rethrow_exception(exc);
+        return std::move(value); }
+    };
+
+    template<>
+    struct Promise<void> : PromiseBase {
+      void return_void(void) { }
+      void result(void) { if (exc) std::rethrow_exception(exc); }
+    };
+  }
+
+  // Lazily started coroutine, run by awaiting it or by Reactor::spawn
+  template<typename T>
+  class Task {
+  public:
+    struct promise_type : detail::Promise<T> {
+      Task get_return_object(void) {
+        return Task { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+    };
+  private:
+    std::coroutine_handle<promise_type> h;
+  public:
+    explicit Task(std::coroutine_handle<promise_type> h) : h { h } { }
+    Task(Task &&t) noexcept : h { std::exchange(t.h, { }) } { }
+    Task &operator=(Task &&t) noexcept {
+      if (this != &t) {
+        if (h) h.destroy();
+        h = std::exchange(t.h, { });
+      }
+      return *this;
+    }
+    ~Task(void) { if (h) h.destroy(); }
+    bool done(void) const { return !h || h.done(); }
+    void start(void) { h.resume(); }
+    T get(void) { return h.promise().result(); }
+    bool await_ready(void) const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> c) noexcept {
+      h.promise().cont = c;
+      return h;
+    }
+    T await_resume(void) { return h.promise().result(); }
+  };
+
+  // Single-threaded event loop. Coroutines suspend on a descriptor until
+  // epoll reports it ready or TOMS elapse, 0 waiting indefinitely.
+  class Reactor {
+    static constexpr std::size_t MAXEV { 256 };
+    using Timers = std::multimap<time_p, std::pair<int, bool>>;
+    struct Waiter {
+      std::coroutine_handle<> h;
+      bool *ok;
+      Timers::iterator t;
+    };
+    struct Watch {
+      std::optional<Waiter> in, out;
+    };
+    int epfd { -1 };
+    std::unordered_map<int, Watch> FDS;
+    Timers TIMERS;
+    std::list<Task<>> TASKS;
+    std::atomic<bool> quit { };
+    void arm(const int);
+    void wake(std::optional<Waiter> &, const bool, std::vector<std::coroutine_handle<>> &);
+  public:
+    struct Wait {
+      Reactor &r;
+      const int FD;
+      const bool OUT;
+      const unsigned TOMS;
+      bool ok { };
+      bool await_ready(void) const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> h) { r.watch(FD, OUT, TOMS, h, &ok); }
+      bool await_resume(void) const noexcept { return ok; }
+    };
+    Reactor(void);
+    ~Reactor(void);
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+    void watch(const int, const bool, const unsigned, std::coroutine_handle<>, bool *);
+    Wait readable(const int FD, const unsigned TOMS = 0) { return { *this, FD, false, TOMS }; }
+    Wait writable(const int FD, const unsigned TOMS = 0) { return { *this, FD, true, TOMS }; }
+    void spawn(Task<> &&);
+    void run(void);
+    void exit(void) { quit = true; }
+    std::size_t taskcount(void) const { return TASKS.size(); }
+  };
+
+  // Awaitable counterparts of the blocking operations. Each suspends
+  // where the socket would block, and fails where TOMS elapse meanwhile.
+  namespace Async {
+    Task<std::string_view> peek(Reactor &, Http &, const unsigned = SINGULAR_TOMS);
+    Task<bool> write(Reactor &, Http &, const std::string, const unsigned = SINGULAR_TOMS);
+    Task<bool> reqhdr(Reactor &, Http &, Header &, const unsigned = SINGULAR_TOMS);
+    Task<bool> reqbody(Reactor &, Http &, const Client_span_cb &, std::size_t,
+      const unsigned = SINGULAR_TOMS);
+    Task<bool> reqchkd(Reactor &, Http &, const Client_span_cb &, const unsigned = SINGULAR_TOMS);
+    Task<bool> performreq(Reactor &, Http &, const std::string &, Handle::Xfr &,
+      const unsigned = SINGULAR_TOMS);
+    template<typename S>
+    Task<bool> performreq(Reactor &r, Client<S> &client, Handle::Xfr &h,
+      const unsigned TOMS = SINGULAR_TOMS) {
+      return performreq(r, client.get_sock(), client.get_host(), h, TOMS);
+    }
+  }
+
+  template<typename S>
+  using Server_co = std::function<Task<bool>(S &)>;
+
+  // Server whose connexions are each a coroutine on the reactor thread.
+  // The callback serves one request and returns false to close.
+  template<typename S>
+  class CoServer {
+    Reactor &reactor;
+    S sock;  // Master
+    ::SSL_CTX *ctx { };
+    Server_co<S> cb;
+    std::atomic<bool> quit { };
+    Task<> listen(void);
+    Task<> serve(std::unique_ptr<S>);
+  public:
+    CoServer(void) = delete;
+    CoServer(Reactor &, const char [], const char [] = CERT, const char [] = KEY);
+    ~CoServer(void);
+    void run(const Server_co<S> &);
+    void exit(void) { quit = true; reactor.exit(); }
+  };
+
+  template class CoServer<Http>;
+  template class CoServer<Https>;
+}
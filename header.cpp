@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <ostream>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include "header.h"
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+static const char *scan_avx2(const char *p, const char *const END, const char c) {
+  const auto C { _mm256_set1_epi8(c) };
+  for (; END - p >= 32; p += 32)
+    if (const unsigned M = _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), C)); M)
+      return p + __builtin_ctz(M);
+  for (; p < END; p++)
+    if (*p == c)
+      return p;
+  return END;
+}
+
+static const char *scan_sse2(const char *p, const char *const END, const char c) {
+  const auto C { _mm_set1_epi8(c) };
+  for (; END - p >= 16; p += 16)
+    if (const unsigned M = _mm_movemask_epi8(_mm_cmpeq_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), C)); M)
+      return p + __builtin_ctz(M);
+  for (; p < END; p++)
+    if (*p == c)
+      return p;
+  return END;
+}
+
+static const auto SCAN {
+  [] { __builtin_cpu_init(); return __builtin_cpu_supports("avx2") ? scan_avx2 : scan_sse2; }()
+};
+#endif
+
+const char *sockpp::scan(const char *p, const char *const END, const char c) {
+#if defined(__x86_64__)
+  return SCAN(p, END, c);
+#else
+  const auto R { std::memchr(p, c, END - p) };
+  return R ? static_cast<const char *>(R) : END;
+#endif
+}
+
+static std::string_view trim(std::string_view v) {
+  while (v.size() && (v.front() == ' ' || v.front() == '\t'))
+    v.remove_prefix(1);
+  while (v.size() && (v.back() == ' ' || v.back() == '\t' || v.back() == '\r'))
+    v.remove_suffix(1);
+  return v;
+}
+
+static char lower(const char c) {
+  return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+bool sockpp::iequals(const std::string_view A, const std::string_view B) {
+  if (A.size() != B.size())
+    return false;
+  for (auto i { 0U }; i < A.size(); i++)
+    if (lower(A[i]) != lower(B[i]))
+      return false;
+  return true;
+}
+
+// Case-insensitive search for token T within a comma separated list V
+static bool hastoken(std::string_view v, const std::string_view T) {
+  while (v.size()) {
+    const auto N { std::min(v.find(','), v.size()) };
+    if (sockpp::iequals(trim(v.substr(0, N)), T))
+      return true;
+    v.remove_prefix(std::min(N + 1, v.size()));
+  }
+
+  return false;
+}
+
+bool sockpp::parsehex(std::string_view v, std::size_t &l) {
+  v = trim(v.substr(0, std::min(v.find(';'), v.size())));
+  if (v.size() > 1 && v[0] == '0' && lower(v[1]) == 'x')
+    v.remove_prefix(2);
+  const auto [P, EC] { std::from_chars(v.data(), v.data() + v.size(), l, 16) };
+  return v.size() && EC == std::errc { } && P == v.data() + v.size();
+}
+
+sockpp::Header &sockpp::Header::operator=(const Header &H) {
+  raw = H.raw;
+  nl = H.nl;
+  done = H.done;
+  sline = { };
+  fields.clear();
+  if (done)
+    parse();
+  return *this;
+}
+
+sockpp::Header &sockpp::Header::operator=(Header &&H) noexcept {
+  if (this != &H)
+    take(std::move(H));
+  return *this;
+}
+
+// Adopt the parse state of H. A short string is copied rather than its
+// buffer handed over, so the views are carried across by offset.
+void sockpp::Header::take(Header &&H) {
+  const char *const OLD { H.raw.data() };
+  raw = std::move(H.raw);
+  const auto REBASE {
+    [this, OLD](const std::string_view V) -> std::string_view {
+      return V.data() ? std::string_view { raw.data() + (V.data() - OLD), V.size() } : V;
+    }
+  };
+
+  sline = REBASE(H.sline);
+  fields = std::move(H.fields);
+  for (auto &f : fields)
+    f = { REBASE(f.first), REBASE(f.second) };
+  nl = H.nl;
+  done = H.done;
+  H.raw.clear();
+  H.sline = { };
+  H.fields.clear();
+  H.nl = 0;
+  H.done = false;
+}
+
+std::size_t sockpp::Header::feed(const std::string_view P) {
+  const char *p { P.data() };
+  const char *const END { p + P.size() };
+  // Line ends ahead of the start line are discarded
+  while (raw.empty() && p < END && (*p == '\r' || *p == '\n'))
+    p++;
+  const char *const BEGIN { p };
+  while (!done && p < END) {
+    const char *const LF { scan(p, END, '\n') };
+    if (std::any_of(p, LF, [](const char c) { return c != '\r'; }))
+      nl = 0;
+    if (LF == END) {
+      p = END;
+      break;
+    }
+
+    p = LF + 1;
+    done = ++nl == 2;
+  }
+
+  raw.append(BEGIN, p);
+  if (done)
+    parse();
+  return p - P.data();
+}
+
+bool sockpp::Header::parse(void) {
+  sline = { };
+  fields.clear();
+  const char *p { raw.data() };
+  const char *const END { p + raw.size() };
+  while (p < END) {
+    const char *const EOL { scan(p, END, '\n') };
+    const std::string_view LINE { trim({ p, static_cast<std::size_t>(EOL - p) }) };
+    p = EOL + (EOL < END);
+    if (LINE.empty()) {
+      // Tolerate empty lines ahead of the start line
+      if (sline.empty())
+        continue;
+      return true;
+    } else if (sline.empty())
+      sline = LINE;
+    else if (const char *const COLON { scan(LINE.data(), LINE.data() + LINE.size(), ':') };
+        COLON < LINE.data() + LINE.size())
+      fields.emplace_back(trim({ LINE.data(), static_cast<std::size_t>(COLON - LINE.data()) }),
+        trim({ COLON + 1, static_cast<std::size_t>(LINE.data() + LINE.size() - COLON - 1) }));
+  }
+
+  return sline.size();
+}
+
+std::string_view sockpp::Header::field(const std::string_view NAME) const {
+  for (const auto &f : fields)
+    if (iequals(f.first, NAME))
+      return f.second;
+  return { };
+}
+
+unsigned sockpp::Header::status(void) const {
+  // Status line: HTTP-version SP status-code SP reason-phrase
+  unsigned s { };
+  if (const auto SP { sline.find(' ') }; sline.substr(0, 5) == "HTTP/" &&
+      SP != std::string_view::npos)
+    std::from_chars(sline.data() + SP + 1, sline.data() + sline.size(), s);
+  return s;
+}
+
+std::size_t sockpp::Header::contentlen(void) const {
+  std::size_t l { };
+  const auto V { field("Content-Length") };
+  std::from_chars(V.data(), V.data() + V.size(), l);
+  return l;
+}
+
+bool sockpp::Header::ischkd(void) const {
+  return hastoken(field("Transfer-Encoding"), "chunked");
+}
+
+bool sockpp::Header::isclose(void) const {
+  return hastoken(field("Connection"), "close");
+}
+
+// Idle timeout in seconds from Keep-Alive: timeout=N, max=M, 0 if absent
+unsigned sockpp::Header::keepalive(void) const {
+  auto v { field("Keep-Alive") };
+  while (v.size()) {
+    const auto N { std::min(v.find(','), v.size()) };
+    if (const auto PARAM { trim(v.substr(0, N)) }; iequals(PARAM.substr(0, 8), "timeout=")) {
+      unsigned t { };
+      std::from_chars(PARAM.data() + 8, PARAM.data() + PARAM.size(), t);
+      return t;
+    }
+
+    v.remove_prefix(std::min(N + 1, v.size()));
+  }
+
+  return 0;
+}
+
+// Resolve a single Range: bytes=first-last, bytes=first- or bytes=-suffix
+// against a representation of SIZE. Absent, invalid or multiple ranges
+// select the whole representation, an unsatisfiable range returns false.
+bool sockpp::Header::range(const std::size_t SIZE, std::size_t &off, std::size_t &l) const {
+  off = 0;
+  l = SIZE;
+  auto v { trim(field("Range")) };
+  if (v.substr(0, 6) != "bytes=" || v.find(',') != std::string_view::npos)
+    return true;
+
+  v.remove_prefix(6);
+  const auto DASH { v.find('-') };
+  if (DASH == std::string_view::npos)
+    return true;
+
+  const auto NUM {
+    [](const std::string_view V, std::size_t &n) {
+      const auto [P, EC] { std::from_chars(V.data(), V.data() + V.size(), n) };
+      return V.size() && EC == std::errc { } && P == V.data() + V.size();
+    }
+  };
+
+  const auto FIRST { trim(v.substr(0, DASH)) }, LAST { trim(v.substr(DASH + 1)) };
+  std::size_t a { }, b { };
+  if (FIRST.empty()) {
+    // Suffix range
+    if (!NUM(LAST, a))
+      return true;
+    else if (!a || !SIZE)
+      return false;
+    off = SIZE - std::min(a, SIZE);
+    l = SIZE - off;
+    return true;
+  } else if (!NUM(FIRST, a) || (LAST.size() && (!NUM(LAST, b) || a > b)))
+    return true;
+  else if (a >= SIZE)
+    return false;
+
+  off = a;
+  l = (LAST.size() ? std::min(b, SIZE - 1) : SIZE - 1) - a + 1;
+  return true;
+}
+
+std::ostream &sockpp::operator<<(std::ostream &os, const Header &H) {
+  return os << H.str();
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <iosfwd>
+#include <vector>
+#include <utility>
+
+namespace sockpp {
+  // Locate the first occurrence of C within [P, END), END if not found
+  const char *scan(const char *, const char *, const char);
+  // Parse a chunk-size line, accepting an optional 0x prefix and extensions
+  bool parsehex(std::string_view, std::size_t &);
+  bool iequals(std::string_view, std::string_view);
+
+  // Resumable header parser. Bytes are fed as they are received up to the
+  // terminating empty line, the index then refers into the owned copy.
+  class Header {
+    std::string raw;
+    std::string_view sline;
+    std::vector<std::pair<std::string_view, std::string_view>> fields;
+    // Consecutive line ends seen, CRs disregarded
+    unsigned char nl { };
+    bool done { };
+    bool parse(void);
+    void take(Header &&);
+  public:
+    Header(void) = default;
+    explicit Header(const std::string_view HDR) : raw { HDR }, done { true } {
+      parse(); }
+    Header(const Header &H) : raw { H.raw }, nl { H.nl }, done { H.done } {
+      if (done) parse(); }
+    Header(Header &&H) noexcept { take(std::move(H)); }
+    Header &operator=(const Header &);
+    Header &operator=(Header &&) noexcept;
+    std::size_t feed(const std::string_view);
+    bool complete(void) const { return done; }
+    void clear(void) { *this = Header { }; }
+    const std::string &str(void) const { return raw; }
+    std::string_view startline(void) const { return sline; }
+    const std::vector<std::pair<std::string_view, std::string_view>> &
+      index(void) const { return fields; }
+    std::string_view field(const std::string_view) const;
+    unsigned status(void) const;
+    std::size_t contentlen(void) const;
+    bool ischkd(void) const;
+    bool isclose(void) const;
+    unsigned keepalive(void) const;
+    bool range(const std::size_t, std::size_t &, std::size_t &) const;
+  };
+
+  std::ostream &operator<<(std::ostream &, const Header &);
+}
@@ -0,0 +1,381 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include "hpack.h"
+
+static const std::array<sockpp::Hpack::Field, 61> STATIC { {
+    { ":authority", "" },
+    { ":method", "GET" },
+    { ":method", "POST" },
+    { ":path", "/" },
+    { ":path", "/index.html" },
+    { ":scheme", "http" },
+    { ":scheme", "https" },
+    { ":status", "200" },
+    { ":status", "204" },
+    { ":status", "206" },
+    { ":status", "304" },
+    { ":status", "400" },
+    { ":status", "404" },
+    { ":status", "500" },
+    { "accept-charset", "" },
+    { "accept-encoding", "gzip, deflate" },
+    { "accept-language", "" },
+    { "accept-ranges", "" },
+    { "accept", "" },
+    { "access-control-allow-origin", "" },
+    { "age", "" },
+    { "allow", "" },
+    { "authorization", "" },
+    { "cache-control", "" },
+    { "content-disposition", "" },
+    { "content-encoding", "" },
+    { "content-language", "" },
+    { "content-length", "" },
+    { "content-location", "" },
+    { "content-range", "" },
+    { "content-type", "" },
+    { "cookie", "" },
+    { "date", "" },
+    { "etag", "" },
+    { "expect", "" },
+    { "expires", "" },
+    { "from", "" },
+    { "host", "" },
+    { "if-match", "" },
+    { "if-modified-since", "" },
+    { "if-none-match", "" },
+    { "if-range", "" },
+    { "if-unmodified-since", "" },
+    { "last-modified", "" },
+    { "link", "" },
+    { "location", "" },
+    { "max-forwards", "" },
+    { "proxy-authenticate", "" },
+    { "proxy-authorization", "" },
+    { "range", "" },
+    { "referer", "" },
+    { "refresh", "" },
+    { "retry-after", "" },
+    { "server", "" },
+    { "set-cookie", "" },
+    { "strict-transport-security", "" },
+    { "transfer-encoding", "" },
+    { "user-agent", "" },
+    { "vary", "" },
+    { "via", "" },
+    { "www-authenticate", "" },
+} };
+
+// Code and bit length of each symbol, EOS last (RFC 7541 Appendix B)
+static constexpr std::array<std::pair<std::uint32_t, unsigned char>, 257> HUFFMAN { {
+    { 0x1ff8, 13 }, { 0x7fffd8, 23 }, { 0xfffffe2, 28 }, { 0xfffffe3, 28 },
+    { 0xfffffe4, 28 }, { 0xfffffe5, 28 }, { 0xfffffe6, 28 }, { 0xfffffe7, 28 },
+    { 0xfffffe8, 28 }, { 0xffffea, 24 }, { 0x3ffffffc, 30 }, { 0xfffffe9, 28 },
+    { 0xfffffea, 28 }, { 0x3ffffffd, 30 }, { 0xfffffeb, 28 }, { 0xfffffec, 28 },
+    { 0xfffffed, 28 }, { 0xfffffee, 28 }, { 0xfffffef, 28 }, { 0xffffff0, 28 },
+    { 0xffffff1, 28 }, { 0xffffff2, 28 }, { 0x3ffffffe, 30 }, { 0xffffff3, 28 },
+    { 0xffffff4, 28 }, { 0xffffff5, 28 }, { 0xffffff6, 28 }, { 0xffffff7, 28 },
+    { 0xffffff8, 28 }, { 0xffffff9, 28 }, { 0xffffffa, 28 }, { 0xffffffb, 28 },
+    { 0x14, 6 }, { 0x3f8, 10 }, { 0x3f9, 10 }, { 0xffa, 12 },
+    { 0x1ff9, 13 }, { 0x15, 6 }, { 0xf8, 8 }, { 0x7fa, 11 },
+    { 0x3fa, 10 }, { 0x3fb, 10 }, { 0xf9, 8 }, { 0x7fb, 11 },
+    { 0xfa, 8 }, { 0x16, 6 }, { 0x17, 6 }, { 0x18, 6 },
+    { 0x0, 5 }, { 0x1, 5 }, { 0x2, 5 }, { 0x19, 6 },
+    { 0x1a, 6 }, { 0x1b, 6 }, { 0x1c, 6 }, { 0x1d, 6 },
+    { 0x1e, 6 }, { 0x1f, 6 }, { 0x5c, 7 }, { 0xfb, 8 },
+    { 0x7ffc, 15 }, { 0x20, 6 }, { 0xffb, 12 }, { 0x3fc, 10 },
+    { 0x1ffa, 13 }, { 0x21, 6 }, { 0x5d, 7 }, { 0x5e, 7 },
+    { 0x5f, 7 }, { 0x60, 7 }, { 0x61, 7 }, { 0x62, 7 },
+    { 0x63, 7 }, { 0x64, 7 }, { 0x65, 7 }, { 0x66, 7 },
+    { 0x67, 7 }, { 0x68, 7 }, { 0x69, 7 }, { 0x6a, 7 },
+    { 0x6b, 7 }, { 0x6c, 7 }, { 0x6d, 7 }, { 0x6e, 7 },
+    { 0x6f, 7 }, { 0x70, 7 }, { 0x71, 7 }, { 0x72, 7 },
+    { 0xfc, 8 }, { 0x73, 7 }, { 0xfd, 8 }, { 0x1ffb, 13 },
+    { 0x7fff0, 19 }, { 0x1ffc, 13 }, { 0x3ffc, 14 }, { 0x22, 6 },
+    { 0x7ffd, 15 }, { 0x3, 5 }, { 0x23, 6 }, { 0x4, 5 },
+    { 0x24, 6 }, { 0x5, 5 }, { 0x25, 6 }, { 0x26, 6 },
+    { 0x27, 6 }, { 0x6, 5 }, { 0x74, 7 }, { 0x75, 7 },
+    { 0x28, 6 }, { 0x29, 6 }, { 0x2a, 6 }, { 0x7, 5 },
+    { 0x2b, 6 }, { 0x76, 7 }, { 0x2c, 6 }, { 0x8, 5 },
+    { 0x9, 5 }, { 0x2d, 6 }, { 0x77, 7 }, { 0x78, 7 },
+    { 0x79, 7 }, { 0x7a, 7 }, { 0x7b, 7 }, { 0x7ffe, 15 },
+    { 0x7fc, 11 }, { 0x3ffd, 14 }, { 0x1ffd, 13 }, { 0xffffffc, 28 },
+    { 0xfffe6, 20 }, { 0x3fffd2, 22 }, { 0xfffe7, 20 }, { 0xfffe8, 20 },
+    { 0x3fffd3, 22 }, { 0x3fffd4, 22 }, { 0x3fffd5, 22 }, { 0x7fffd9, 23 },
+    { 0x3fffd6, 22 }, { 0x7fffda, 23 }, { 0x7fffdb, 23 }, { 0x7fffdc, 23 },
+    { 0x7fffdd, 23 }, { 0x7fffde, 23 }, { 0xffffeb, 24 }, { 0x7fffdf, 23 },
+    { 0xffffec, 24 }, { 0xffffed, 24 }, { 0x3fffd7, 22 }, { 0x7fffe0, 23 },
+    { 0xffffee, 24 }, { 0x7fffe1, 23 }, { 0x7fffe2, 23 }, { 0x7fffe3, 23 },
+    { 0x7fffe4, 23 }, { 0x1fffdc, 21 }, { 0x3fffd8, 22 }, { 0x7fffe5, 23 },
+    { 0x3fffd9, 22 }, { 0x7fffe6, 23 }, { 0x7fffe7, 23 }, { 0xffffef, 24 },
+    { 0x3fffda, 22 }, { 0x1fffdd, 21 }, { 0xfffe9, 20 }, { 0x3fffdb, 22 },
+    { 0x3fffdc, 22 }, { 0x7fffe8, 23 }, { 0x7fffe9, 23 }, { 0x1fffde, 21 },
+    { 0x7fffea, 23 }, { 0x3fffdd, 22 }, { 0x3fffde, 22 }, { 0xfffff0, 24 },
+    { 0x1fffdf, 21 }, { 0x3fffdf, 22 }, { 0x7fffeb, 23 }, { 0x7fffec, 23 },
+    { 0x1fffe0, 21 }, { 0x1fffe1, 21 }, { 0x3fffe0, 22 }, { 0x1fffe2, 21 },
+    { 0x7fffed, 23 }, { 0x3fffe1, 22 }, { 0x7fffee, 23 }, { 0x7fffef, 23 },
+    { 0xfffea, 20 }, { 0x3fffe2, 22 }, { 0x3fffe3, 22 }, { 0x3fffe4, 22 },
+    { 0x7ffff0, 23 }, { 0x3fffe5, 22 }, { 0x3fffe6, 22 }, { 0x7ffff1, 23 },
+    { 0x3ffffe0, 26 }, { 0x3ffffe1, 26 }, { 0xfffeb, 20 }, { 0x7fff1, 19 },
+    { 0x3fffe7, 22 }, { 0x7ffff2, 23 }, { 0x3fffe8, 22 }, { 0x1ffffec, 25 },
+    { 0x3ffffe2, 26 }, { 0x3ffffe3, 26 }, { 0x3ffffe4, 26 }, { 0x7ffffde, 27 },
+    { 0x7ffffdf, 27 }, { 0x3ffffe5, 26 }, { 0xfffff1, 24 }, { 0x1ffffed, 25 },
+    { 0x7fff2, 19 }, { 0x1fffe3, 21 }, { 0x3ffffe6, 26 }, { 0x7ffffe0, 27 },
+    { 0x7ffffe1, 27 }, { 0x3ffffe7, 26 }, { 0x7ffffe2, 27 }, { 0xfffff2, 24 },
+    { 0x1fffe4, 21 }, { 0x1fffe5, 21 }, { 0x3ffffe8, 26 }, { 0x3ffffe9, 26 },
+    { 0xffffffd, 28 }, { 0x7ffffe3, 27 }, { 0x7ffffe4, 27 }, { 0x7ffffe5, 27 },
+    { 0xfffec, 20 }, { 0xfffff3, 24 }, { 0xfffed, 20 }, { 0x1fffe6, 21 },
+    { 0x3fffe9, 22 }, { 0x1fffe7, 21 }, { 0x1fffe8, 21 }, { 0x7ffff3, 23 },
+    { 0x3fffea, 22 }, { 0x3fffeb, 22 }, { 0x1ffffee, 25 }, { 0x1ffffef, 25 },
+    { 0xfffff4, 24 }, { 0xfffff5, 24 }, { 0x3ffffea, 26 }, { 0x7ffff4, 23 },
+    { 0x3ffffeb, 26 }, { 0x7ffffe6, 27 }, { 0x3ffffec, 26 }, { 0x3ffffed, 26 },
+    { 0x7ffffe7, 27 }, { 0x7ffffe8, 27 }, { 0x7ffffe9, 27 }, { 0x7ffffea, 27 },
+    { 0x7ffffeb, 27 }, { 0xffffffe, 28 }, { 0x7ffffec, 27 }, { 0x7ffffed, 27 },
+    { 0x7ffffee, 27 }, { 0x7ffffef, 27 }, { 0x7fffff0, 27 }, { 0x3ffffee, 26 },
+    { 0x3fffffff, 30 },
+} };
+
+// The codes are canonical: those of one length are consecutive, ordered
+// by symbol and continue on from those of the previous length
+struct Canon {
+  std::array<std::uint32_t, 31> first { };
+  std::array<std::uint16_t, 31> count { }, offset { };
+  std::array<std::uint16_t, 257> sym { };
+};
+
+static const Canon CANON { [] {
+  Canon c;
+  for (auto i { 0U }; i < c.sym.size(); i++)
+    c.sym[i] = i;
+  std::stable_sort(c.sym.begin(), c.sym.end(), [](const auto A, const auto B) {
+    return HUFFMAN[A].second < HUFFMAN[B].second; });
+  for (auto i { c.sym.size() }; i--;) {
+    const auto &[CODE, L] { HUFFMAN[c.sym[i]] };
+    c.first[L] = CODE;
+    c.offset[L] = i;
+    c.count[L]++;
+  }
+  return c;
+}() };
+
+static std::size_t entrysize(const sockpp::Hpack::Field &F) {
+  return F.first.size() + F.second.size() + 32;
+}
+
+static void putint(std::string &out, const unsigned char FLAGS, const unsigned N, std::size_t v) {
+  const std::size_t MAX { (1U << N) - 1 };
+  if (v < MAX) {
+    out += static_cast<char>(FLAGS | v);
+    return;
+  }
+
+  out += static_cast<char>(FLAGS | MAX);
+  for (v -= MAX; v >= 128; v >>= 7)
+    out += static_cast<char>(v % 128 + 128);
+  out += static_cast<char>(v);
+}
+
+static bool getint(std::string_view &in, const unsigned N, std::size_t &v) {
+  if (in.empty())
+    return false;
+  const std::size_t MAX { (1U << N) - 1 };
+  v = static_cast<unsigned char>(in[0]) & MAX;
+  in.remove_prefix(1);
+  if (v < MAX)
+    return true;
+  for (auto m { 0U }; in.size() && m < 56; m += 7) {
+    const auto B { static_cast<unsigned char>(in[0]) };
+    in.remove_prefix(1);
+    v += static_cast<std::size_t>(B & 127) << m;
+    if (!(B & 128))
+      return true;
+  }
+
+  return false;
+}
+
+// Huffman coded where shorter
+static void putstr(std::string &out, const std::string_view S) {
+  std::size_t bits { };
+  for (const auto c : S)
+    bits += HUFFMAN[static_cast<unsigned char>(c)].second;
+  if ((bits + 7) / 8 >= S.size()) {
+    putint(out, 0, 7, S.size());
+    out += S;
+    return;
+  }
+
+  putint(out, 0x80, 7, (bits + 7) / 8);
+  std::uint64_t acc { };
+  auto n { 0U };
+  for (const auto c : S) {
+    const auto &[CODE, L] { HUFFMAN[static_cast<unsigned char>(c)] };
+    acc = acc << L | CODE;
+    for (n += L; n >= 8; n -= 8)
+      out += static_cast<char>(acc >> (n - 8));
+    acc &= (1U << n) - 1;
+  }
+
+  // Padded with the most significant bits of EOS
+  if (n)
+    out += static_cast<char>(acc << (8 - n) | 0xff >> n);
+}
+
+static bool huffdecode(const std::string_view P, std::string &s) {
+  std::uint32_t code { };
+  auto l { 0U };
+  for (const auto c : P)
+    for (auto b { 8 }; b--;) {
+      code = code << 1 | (static_cast<unsigned char>(c) >> b & 1);
+      if (++l >= CANON.first.size())
+        return false;
+      else if (code - CANON.first[l] < CANON.count[l]) {
+        const auto SYM { CANON.sym[CANON.offset[l] + code - CANON.first[l]] };
+        if (SYM == 256)
+          return false;
+        s += static_cast<char>(SYM);
+        code = 0;
+        l = 0;
+      }
+    }
+
+  return l < 8 && code == (1U << l) - 1;
+}
+
+static bool getstr(std::string_view &in, std::string &s) {
+  if (in.empty())
+    return false;
+  const bool HUFF { static_cast<unsigned char>(in[0]) >= 0x80 };
+  std::size_t l { };
+  if (!getint(in, 7, l) || l > in.size())
+    return false;
+  const auto P { in.substr(0, l) };
+  in.remove_prefix(l);
+  s.clear();
+  if (HUFF)
+    return huffdecode(P, s);
+  s.assign(P);
+  return true;
+}
+
+void sockpp::Hpack::Table::evict(const std::size_t N) {
+  while (dyn.size() && size + N > max) {
+    size -= entrysize(dyn.back());
+    dyn.pop_back();
+  }
+}
+
+const sockpp::Hpack::Field *sockpp::Hpack::Table::get(const std::size_t I) const {
+  if (I && I <= STATIC.size())
+    return &STATIC[I - 1];
+  else if (I > STATIC.size() && I - STATIC.size() <= dyn.size())
+    return &dyn[I - STATIC.size() - 1];
+  return nullptr;
+}
+
+// An entry larger than the table empties it
+void sockpp::Hpack::Table::add(const Field &F) {
+  const auto N { entrysize(F) };
+  evict(N);
+  if (N > max)
+    return;
+  dyn.push_front(F);
+  size += N;
+}
+
+void sockpp::Hpack::Table::resize(const std::size_t MAX) {
+  max = MAX;
+  evict(0);
+}
+
+std::size_t sockpp::Hpack::Table::find(const Field &F, bool &full) const {
+  std::size_t name { };
+  full = true;
+  for (auto i { 0U }; i < STATIC.size() + dyn.size(); i++) {
+    const auto &E { i < STATIC.size() ? STATIC[i] : dyn[i - STATIC.size()] };
+    if (E.first != F.first)
+      continue;
+    else if (E.second == F.second)
+      return i + 1;
+    else if (!name)
+      name = i + 1;
+  }
+
+  full = false;
+  return name;
+}
+
+// Table size limited by the peer and by the default of 4096
+void sockpp::Hpack::Encoder::set_limit(const std::size_t LIMIT) {
+  if (const auto N { std::min<std::size_t>(LIMIT, 4096) }; N != table.capacity()) {
+    table.resize(N);
+    update = true;
+  }
+}
+
+std::string sockpp::Hpack::Encoder::encode(const std::vector<Field> &FIELDS) {
+  std::string block;
+  if (update) {
+    putint(block, 0x20, 5, table.capacity());
+    update = false;
+  }
+
+  for (const auto &f : FIELDS) {
+    bool full { };
+    const auto I { table.find(f, full) };
+    if (full) {
+      putint(block, 0x80, 7, I);
+      continue;
+    }
+
+    // Literal with incremental indexing
+    putint(block, 0x40, 6, I);
+    if (!I)
+      putstr(block, f.first);
+    putstr(block, f.second);
+    table.add(f);
+  }
+
+  return block;
+}
+
+bool sockpp::Hpack::Decoder::decode(std::string_view block, std::vector<Field> &fields) {
+  while (block.size()) {
+    const auto B { static_cast<unsigned char>(block[0]) };
+    std::size_t i { };
+    if (B & 0x80) {
+      const Field *f { };
+      if (!getint(block, 7, i) || !(f = table.get(i)))
+        return false;
+      fields.emplace_back(*f);
+      continue;
+    } else if ((B & 0xe0) == 0x20) {
+      // Table size update, within the default we advertise
+      if (!getint(block, 5, i) || i > 4096)
+        return false;
+      table.resize(i);
+      continue;
+    }
+
+    // Literal, with incremental indexing or else without
+    const bool INDEX { (B & 0x40) > 0 };
+    Field f;
+    const Field *name { };
+    if (!getint(block, INDEX ? 6 : 4, i))
+      return false;
+    else if (i && !(name = table.get(i)))
+      return false;
+    else if (name)
+      f.first = name->first;
+    else if (!getstr(block, f.first))
+      return false;
+    if (!getstr(block, f.second))
+      return false;
+    if (INDEX)
+      table.add(f);
+    fields.emplace_back(std::move(f));
+  }
+
+  return true;
+}
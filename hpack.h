@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <utility>
+
+namespace sockpp {
+  // HPACK header compression (RFC 7541)
+  namespace Hpack {
+    using Field = std::pair<std::string, std::string>;
+
+    // Dynamic table of one direction of a connexion, newest entry first.
+    // Indices continue on from the static table.
+    class Table {
+      std::deque<Field> dyn;
+      std::size_t size { }, max { 4096 };
+      void evict(const std::size_t);
+    public:
+      const Field *get(const std::size_t) const;
+      void add(const Field &);
+      void resize(const std::size_t);
+      std::size_t capacity(void) const { return max; }
+      // Index of a full match, else of a name match (NAME), 0 if none
+      std::size_t find(const Field &, bool &) const;
+    };
+
+    class Encoder {
+      Table table;
+      // Peer limit on the table size, announced ahead of the next block
+      std::size_t limit { 4096 };
+      bool update { };
+    public:
+      void set_limit(const std::size_t);
+      std::string encode(const std::vector<Field> &);
+    };
+
+    class Decoder {
+      Table table;
+    public:
+      bool decode(std::string_view, std::vector<Field> &);
+    };
+  }
+}
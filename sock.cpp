@@ -23,36 +23,143 @@ SOFTWARE.
 **********************************************************************************/
 
 #include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <climits>
+#include <pthread.h>
+#include <sched.h>
 #include <cmath>
+#include <cstring>
+#include <charconv>
+#include <ctime>
 #include <libsockpp/sock.h>
 #include <libsockpp/time.h>
 
-static const unsigned char LISTEN_QLEN { 16 };
+std::mutex sockpp::Resolver::mtx;
+std::unordered_map<std::string, sockpp::Resolver::Entry> sockpp::Resolver::CACHE;
+std::atomic<unsigned> sockpp::Resolver::ttl { 30000 };
+std::atomic<std::size_t> sockpp::Resolver::lookups;
+std::mutex sockpp::SessionCache::mtx;
+std::unordered_map<std::string, std::deque<::SSL_SESSION *>> sockpp::SessionCache::SESS;
+std::atomic<std::size_t> sockpp::SessionCache::hits, sockpp::SessionCache::misses;
 
-bool sockpp::Http::init_client(const char HOST[], const char PORT[]) {
-  struct ::addrinfo hints { };
-  hints.ai_family = AF_UNSPEC;
-  hints.ai_socktype = SOCK_STREAM;
-  hints.ai_flags = { };
-  hints.ai_protocol = { };
-  struct ::addrinfo *result;
-  if (::getaddrinfo(HOST, PORT, &hints, &result))
-    return false;
-  for (struct ::addrinfo *rp { result }; rp; rp = rp->ai_next) {
-    if ((sockfd = ::socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol)) > -1 &&
-          ::connect(sockfd, rp->ai_addr, rp->ai_addrlen) > -1) {
-      ::freeaddrinfo(result);
-      return true;
+static std::string peerport(const int FD) {
+  struct ::sockaddr_storage addr { };
+  ::socklen_t len { sizeof addr };
+  if (::getpeername(FD, reinterpret_cast<struct ::sockaddr *>(&addr), &len) < 0)
+    return { };
+  return std::to_string(::ntohs(addr.ss_family == AF_INET6 ?
+    reinterpret_cast<struct ::sockaddr_in6 *>(&addr)->sin6_port :
+      reinterpret_cast<struct ::sockaddr_in *>(&addr)->sin_port));
+}
+
+// Options of either end, each set only where requested
+static bool setopts(const int FD, const sockpp::Sockopts &OPTS) {
+  const int ON { 1 };
+  return (!OPTS.nodelay || ::setsockopt(FD, IPPROTO_TCP, TCP_NODELAY, &ON, sizeof ON) > -1) &&
+    (!OPTS.quickack || ::setsockopt(FD, IPPROTO_TCP, TCP_QUICKACK, &ON, sizeof ON) > -1) &&
+      (!OPTS.rcvbuf ||
+        ::setsockopt(FD, SOL_SOCKET, SO_RCVBUF, &OPTS.rcvbuf, sizeof OPTS.rcvbuf) > -1) &&
+      (!OPTS.sndbuf ||
+        ::setsockopt(FD, SOL_SOCKET, SO_SNDBUF, &OPTS.sndbuf, sizeof OPTS.sndbuf) > -1) &&
+      (!OPTS.busypoll ||
+        ::setsockopt(FD, SOL_SOCKET, SO_BUSY_POLL, &OPTS.busypoll, sizeof OPTS.busypoll) > -1);
+}
+
+// Race non-blocking connexions to the addresses of HOST, alternating
+// address families. Each attempt starts STAGGER_TOMS after the previous
+// or as soon as it fails. The first established within the connect
+// deadline is kept. Buffer sizes precede the connect, which fixes the
+// window scale. The name lookup counts towards the deadline.
+bool sockpp::Http::init_client(const char HOST[], const char PORT[], const Sockopts &OPTS) {
+  const auto TOMS { OPTS.connect_toms };
+  Time time;
+  const auto INITTIME { time.now() };
+  Resolver::Addrs A;
+  {
+    const auto ADDRS { Resolver::lookup(HOST, PORT, TOMS) };
+    std::vector<Resolver::Addr> pref, alt;
+    for (const auto &a : ADDRS)
+      (a.family == ADDRS[0].family ? pref : alt).emplace_back(a);
+    for (auto i { 0U }; i < std::max(pref.size(), alt.size()); i++) {
+      if (i < pref.size())
+        A.emplace_back(pref[i]);
+      if (i < alt.size())
+        A.emplace_back(alt[i]);
     }
-    
-    deinit();
   }
 
-  ::freeaddrinfo(result);
+  std::vector<struct ::pollfd> P;
+  std::size_t next { };
+  auto start { [&](void) {
+    while (next < A.size()) {
+      const auto &a { A[next++] };
+      const int ON { 1 };
+      const auto FD { ::socket(a.family, a.socktype | SOCK_NONBLOCK, a.protocol) };
+      if (FD < 0)
+        continue;
+      // A TFO connect() returns before the handshake, at once, so it would
+      // win any race. It is left to a lone address.
+      else if (!setopts(FD, OPTS) || (OPTS.fastopen && A.size() == 1 &&
+          ::setsockopt(FD, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &ON, sizeof ON) < 0));
+      else if (!::connect(FD, reinterpret_cast<const ::sockaddr *>(&a.addr), a.addrlen) ||
+          errno == EINPROGRESS) {
+        P.push_back({ FD, POLLOUT, 0 });
+        return;
+      }
+
+      ::close(FD);
+    }
+  } };
+
+  start();
+  std::size_t elapsed { };
+  while (P.size() && (elapsed = time.diffpt<std::chrono::milliseconds>(time.now(), INITTIME)) < TOMS) {
+    const auto WAIT { next < A.size() ? std::min<std::size_t>(STAGGER_TOMS, TOMS - elapsed) :
+      TOMS - elapsed };
+    if (::poll(P.data(), P.size(), WAIT) < 1) {
+      start();
+      continue;
+    }
+
+    for (auto it { P.begin() }; it != P.end();) {
+      int err { };
+      ::socklen_t len { sizeof err };
+      if (!it->revents) {
+        it++;
+        continue;
+      } else if (!::getsockopt(it->fd, SOL_SOCKET, SO_ERROR, &err, &len) && !err) {
+        sockfd = it->fd;
+        P.erase(it);
+        for (const auto &p : P)
+          ::close(p.fd);
+        if (set_nonblock(false))
+          return true;
+        deinit();
+        return false;
+      }
+
+      ::close(it->fd);
+      it = P.erase(it);
+    }
+
+    if (P.empty())
+      start();
+  }
+
+  for (const auto &p : P)
+    ::close(p.fd);
   return false;
 }
 
-bool sockpp::Http::init_server(const char PORT[]) {
+// Options set on the listener carry over to the connexions it accepts
+bool sockpp::Http::init_server(const char PORT[], const Sockopts &OPTS) {
   struct ::addrinfo hints { };
   hints.ai_family = AF_UNSPEC;
   hints.ai_socktype = SOCK_STREAM;
@@ -65,9 +172,19 @@ bool sockpp::Http::init_server(const char PORT[]) {
   if (::getaddrinfo(nullptr, PORT, &hints, &result))
     return false;
   for (struct ::addrinfo *rp { result }; rp; rp = rp->ai_next) {
+    const int ON { 1 };
     if ((sockfd = ::socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol)) > -1 &&
+          setopts(sockfd, OPTS) &&
+          (!OPTS.reuseaddr ||
+            ::setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &ON, sizeof ON) > -1) &&
+          (!OPTS.reuseport ||
+            ::setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &ON, sizeof ON) > -1) &&
+          (!OPTS.fastopen || ::setsockopt(sockfd, IPPROTO_TCP, TCP_FASTOPEN,
+            &OPTS.fastopen, sizeof OPTS.fastopen) > -1) &&
+          (!OPTS.deferaccept || ::setsockopt(sockfd, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+            &OPTS.deferaccept, sizeof OPTS.deferaccept) > -1) &&
           ::bind(sockfd, rp->ai_addr, rp->ai_addrlen) > -1 &&
-            ::listen(sockfd, LISTEN_QLEN) > -1) {
+            ::listen(sockfd, OPTS.backlog) > -1) {
       ::freeaddrinfo(result);
       return true;
     }
@@ -84,6 +201,126 @@ void sockpp::Http::deinit(void) {
     sockfd = -1;
 }
 
+bool sockpp::Http::set_opts(const Sockopts &OPTS) const {
+  return setopts(sockfd, OPTS);
+}
+
+bool sockpp::Http::set_nonblock(const bool NONBLOCK) {
+  const auto FLAGS { ::fcntl(sockfd, F_GETFL) };
+  return FLAGS > -1 && ::fcntl(sockfd, F_SETFL,
+    NONBLOCK ? FLAGS | O_NONBLOCK : FLAGS & ~O_NONBLOCK) > -1;
+}
+
+// Write all of P, resuming after short writes. MORE holds back a partial
+// segment for the data which follows.
+bool sockpp::Http::sendraw(const char p[], std::size_t l, const bool MORE) const {
+  struct ::pollfd pollfd { sockfd, POLLOUT, 0 };
+  while (l)
+    if (const auto N { ::send(sockfd, p, l, MORE ? MSG_MORE : 0) }; N > 0) {
+      p += N;
+      l -= N;
+    } else if (N < 0 && errno == EINTR);
+    else if (N < 0 && errno == EAGAIN &&
+        ::poll(&pollfd, 1, SINGULAR_TOMS) > 0 && (pollfd.revents & POLLOUT));
+    else
+      return false;
+
+  return true;
+}
+
+// Sent IOV_MAX spans at a time, advancing past what each sendmsg took
+bool sockpp::Http::write(const std::vector<std::string_view> &V, const bool MORE) const {
+  std::vector<struct ::iovec> iov;
+  iov.reserve(V.size());
+  for (const auto &P : V)
+    if (P.size())
+      iov.push_back({ const_cast<char *>(P.data()), P.size() });
+
+  struct ::pollfd pollfd { sockfd, POLLOUT, 0 };
+  struct ::msghdr msg { };
+  for (auto *v { iov.data() }, *const END { iov.data() + iov.size() }; v < END;) {
+    msg.msg_iov = v;
+    msg.msg_iovlen = std::min<long>(END - v, IOV_MAX);
+    if (const auto N { ::sendmsg(sockfd, &msg, MORE ? MSG_MORE : 0) }; N > 0) {
+      auto n { static_cast<std::size_t>(N) };
+      for (; v < END && n >= v->iov_len; v++)
+        n -= v->iov_len;
+      if (n) {
+        v->iov_base = static_cast<char *>(v->iov_base) + n;
+        v->iov_len -= n;
+      }
+    } else if (N < 0 && errno == EINTR);
+    else if (N < 0 && errno == EAGAIN &&
+        ::poll(&pollfd, 1, SINGULAR_TOMS) > 0 && (pollfd.revents & POLLOUT));
+    else
+      return false;
+  }
+
+  return true;
+}
+
+bool sockpp::Http::flush(void) {
+  while (wpos < wbuf.size())
+    if (const auto N { ::send(sockfd, wbuf.data() + wpos, wbuf.size() - wpos, MSG_DONTWAIT) };
+        N > 0)
+      wpos += N;
+    else if (N < 0 && errno == EINTR);
+    else if (N < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return true;
+    else
+      return false;
+
+  wbuf.clear();
+  wpos = 0;
+  return true;
+}
+
+bool sockpp::Http::sendfile(const int FD, ::off_t off, std::size_t l) const {
+  struct ::pollfd pollfd { sockfd, POLLOUT, 0 };
+  while (l)
+    if (const auto N { ::sendfile(sockfd, FD, &off, l) }; N > 0)
+      l -= N;
+    else if (N < 0 && errno == EINTR);
+    else if (N < 0 && errno == EAGAIN &&
+        ::poll(&pollfd, 1, SINGULAR_TOMS) > 0 && (pollfd.revents & POLLOUT));
+    else
+      return false;
+
+  return true;
+}
+
+// Respond to the request REQ with the file FD, or the byte range of it
+// the request selects, after the header lines HEAD
+bool sockpp::Http::sendfile(const Header &REQ, const int FD, const std::vector<std::string> &HEAD) const {
+  struct ::stat st { };
+  if (::fstat(FD, &st) < 0)
+    return false;
+
+  const std::size_t SIZE = st.st_size;
+  std::size_t off { }, l { };
+  std::string hdr;
+  const auto SAT { REQ.range(SIZE, off, l) };
+  if (!SAT)
+    hdr = "HTTP/1.1 416 Range Not Satisfiable\r\n"
+      "Content-Range: bytes */" + std::to_string(SIZE) + "\r\n"
+        "Content-Length: 0\r\n";
+  else if (l < SIZE)
+    hdr = "HTTP/1.1 206 Partial Content\r\n"
+      "Content-Range: bytes " + std::to_string(off) + "-" + std::to_string(off + l - 1) +
+        "/" + std::to_string(SIZE) + "\r\n"
+          "Content-Length: " + std::to_string(l) + "\r\n";
+  else
+    hdr = "HTTP/1.1 200 OK\r\n"
+      "Content-Length: " + std::to_string(l) + "\r\n";
+
+  for (const auto &h : HEAD)
+    hdr += h + "\r\n";
+
+  hdr += "Accept-Ranges: bytes\r\n\r\n";
+  // Held back for the payload only where there is one
+  return SAT && l ? writemore(hdr) && sendfile(FD, off, l) : write(hdr);
+}
+
 bool sockpp::Http::pollin(const int TOMS) {
   pollfd.events = POLLIN;
   pollfd.revents = 0;
@@ -104,6 +341,166 @@ bool sockpp::Http::pollerr(const int TOMS) {
   return ::poll(&pollfd, 1, TOMS) > 0 && (pollfd.revents & event);
 }
 
+std::size_t sockpp::Http::compact(void) {
+  if (rbuf.empty())
+    rbuf.resize(RBN);
+  std::memmove(rbuf.data(), rbuf.data() + rpos, rlen - rpos);
+  rlen -= rpos;
+  rpos = 0;
+  return rbuf.size() - rlen;
+}
+
+// Read retried on EINTR. Only end of stream or a hard error is final,
+// -1 with errno EAGAIN leaves the connexion open.
+static ssize_t readfd(const int FD, char p[], const std::size_t L, bool &eof) {
+  ssize_t N { };
+  while ((N = ::read(FD, p, L)) < 0 && errno == EINTR);
+  eof = !N || (N < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+  return N;
+}
+
+// Receive after any unconsumed bytes
+bool sockpp::Http::fill(const int TOMS) {
+  const auto ROOM { compact() };
+  ssize_t N { };
+  if (!ROOM || !pollin(TOMS) || (N = readfd(sockfd, rbuf.data() + rlen, ROOM, eof)) < 1)
+    return false;
+
+  rlen += N;
+  return true;
+}
+
+bool sockpp::Http::read(char &p, const int TOMS) {
+  if (rpos == rlen && !fill(TOMS))
+    return false;
+  p = rbuf[rpos++];
+  return true;
+}
+
+std::string_view sockpp::Http::read(const std::size_t N, const int TOMS) {
+  const auto P { peek(TOMS).substr(0, N) };
+  consume(P.size());
+  return P;
+}
+
+std::string_view sockpp::Http::peek(const int TOMS) {
+  if (rpos == rlen && !fill(TOMS))
+    return { };
+  return { rbuf.data() + rpos, rlen - rpos };
+}
+
+std::string_view sockpp::Http::peekmore(const int TOMS) {
+  fill(TOMS);
+  return { rbuf.data() + rpos, rlen - rpos };
+}
+
+sockpp::Resolver::Addrs sockpp::Resolver::getaddrinfo(const std::string HOST, const std::string PORT) {
+  struct ::addrinfo hints { };
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct ::addrinfo *result;
+  Addrs addrs;
+  lookups++;
+  if (::getaddrinfo(HOST.c_str(), PORT.c_str(), &hints, &result))
+    return addrs;
+  for (struct ::addrinfo *rp { result }; rp; rp = rp->ai_next) {
+    Addr a { rp->ai_family, rp->ai_socktype, rp->ai_protocol, { }, rp->ai_addrlen };
+    std::memcpy(&a.addr, rp->ai_addr, rp->ai_addrlen);
+    addrs.emplace_back(a);
+  }
+
+  ::freeaddrinfo(result);
+  return addrs;
+}
+
+// Resolution of HOST:PORT, cached or pending, else started on another thread
+std::shared_future<sockpp::Resolver::Addrs> sockpp::Resolver::resolve(const std::string &HOST, const std::string &PORT) {
+  const auto KEY { HOST + ":" + PORT };
+  const auto NOW { Time { }.now() };
+  std::lock_guard<std::mutex> lock { mtx };
+  if (const auto it { CACHE.find(KEY) }; it != CACHE.end()) {
+    auto &[addrs, expiry] { it->second };
+    if (addrs.wait_for(std::chrono::seconds(0)) != std::future_status::ready ||
+        (addrs.get().size() && expiry > NOW))
+      return addrs;
+  }
+
+  for (auto it { CACHE.begin() }; it != CACHE.end();)
+    if (const auto &[addrs, expiry] { it->second };
+        addrs.wait_for(std::chrono::seconds(0)) == std::future_status::ready &&
+          (addrs.get().empty() || expiry <= NOW))
+      it = CACHE.erase(it);
+    else
+      it++;
+
+  auto &e { CACHE[KEY] };
+  e.addrs = std::async(std::launch::async, getaddrinfo, HOST, PORT).share();
+  e.expiry = NOW + std::chrono::milliseconds(ttl);
+  return e.addrs;
+}
+
+void sockpp::Resolver::clear(void) {
+  // A pending lookup completes outside the lock
+  std::unordered_map<std::string, Entry> cache;
+  std::lock_guard<std::mutex> lock { mtx };
+  cache.swap(CACHE);
+}
+
+// Returns a referenced session to be freed by the caller, or nullptr.
+// TLS 1.3 tickets are single use and so leave the cache.
+::SSL_SESSION *sockpp::SessionCache::get(const std::string &KEY) {
+  std::lock_guard<std::mutex> lock { mtx };
+  const auto it { SESS.find(KEY) };
+  if (it == SESS.end())
+    return nullptr;
+
+  for (auto &Q { it->second }; Q.size();) {
+    ::SSL_SESSION *sess { Q.back() };
+    if (!::SSL_SESSION_is_resumable(sess) ||
+        ::SSL_SESSION_get_time(sess) + ::SSL_SESSION_get_timeout(sess) <
+          static_cast<long>(std::time(nullptr))) {
+      ::SSL_SESSION_free(sess);
+      Q.pop_back();
+    } else if (::SSL_SESSION_get_protocol_version(sess) >= TLS1_3_VERSION) {
+      Q.pop_back();
+      return sess;
+    } else {
+      ::SSL_SESSION_up_ref(sess);
+      return sess;
+    }
+  }
+
+  return nullptr;
+}
+// Takes ownership of the session reference
+void sockpp::SessionCache::put(const std::string &KEY, ::SSL_SESSION *sess) {
+  std::lock_guard<std::mutex> lock { mtx };
+  auto &Q { SESS[KEY] };
+  Q.emplace_back(sess);
+  if (Q.size() > MAXN) {
+    ::SSL_SESSION_free(Q.front());
+    Q.pop_front();
+  }
+}
+
+void sockpp::SessionCache::clear(void) {
+  std::lock_guard<std::mutex> lock { mtx };
+  for (auto &[key, Q] : SESS)
+    for (auto sess : Q)
+      ::SSL_SESSION_free(sess);
+  SESS.clear();
+}
+
+// New session callback, fired following a full handshake (session ID) or
+// on receipt of a ticket, which in TLS 1.3 follows the handshake
+int sockpp::Https::newsess(::SSL *ssl, ::SSL_SESSION *sess) {
+  const auto *https { static_cast<const Https *>(SSL_get_app_data(ssl)) };
+  if (!https || https->sesskey.empty())
+    return 0;
+  SessionCache::put(https->sesskey, sess);
+  return 1;
+}
+
 void sockpp::Https::deinit(void) const {
   if (ssl) {
     ::SSL_shutdown(ssl);
@@ -121,24 +518,219 @@ bool sockpp::Https::configure_ctx(const char CERT[], const char KEY[]) const {
         SSL_CTX_check_private_key(ctx) > 0;
 }
 
+::SSL_CTX *sockpp::Https::server_ctx(const char CERT[], const char KEY[]) {
+  ::SSL_CTX *ctx { ::SSL_CTX_new(::TLS_server_method()) };
+  if (!ctx)
+    return nullptr;
+  
+  SSL_CTX_set_ecdh_auto(ctx, 1);
+  if (SSL_CTX_use_certificate_chain_file(ctx, CERT) < 1 ||
+      SSL_CTX_use_PrivateKey_file(ctx, KEY, SSL_FILETYPE_PEM) < 1 ||
+        SSL_CTX_check_private_key(ctx) < 1) {
+    ::SSL_CTX_free(ctx);
+    return nullptr;
+  }
+
+  return ctx;
+}
+
+sockpp::HS sockpp::Https::handshake(void) const {
+  if (const auto R { ::SSL_do_handshake(ssl) }; R == 1)
+    return HS::DONE;
+  else switch (::SSL_get_error(ssl, R)) {
+    case SSL_ERROR_WANT_READ: return HS::WANTR;
+    case SSL_ERROR_WANT_WRITE: return HS::WANTW;
+    default: return HS::FAIL;
+  }
+}
+
+bool sockpp::Https::init(::SSL_CTX *ctx) {
+  if (!(ssl = ::SSL_new(ctx)))
+    return false;
+  // OpenSSL installs the negotiated keys with TCP_ULP "tls" at handshake
+  // where the kernel and cipher support it, else continues in userspace
+  if (optktls)
+    ::SSL_set_options(ssl, SSL_OP_ENABLE_KTLS);
+  return true;
+}
+
+// Following the handshake, records go through the memory BIOs unless
+// the kernel took over transmission, in which case the socket BIO stays
+bool sockpp::Https::init_rwbio(void) {
+  if (optktls && BIO_get_ktls_send(::SSL_get_wbio(ssl)))
+    return (ktls = true);
+  else if (!init_rbio() || !init_wbio())
+    return false;
+  set_rwbio();
+  return true;
+}
+
 bool sockpp::Https::connect(const char HOST[]) {
-  if (Https::init_client() && init() && set_hostname(HOST)) {
-      set_connect_state();
-      if (set_fd(Http::sockfd) && do_handshake() && init_rbio() && init_wbio()) {
-        set_rwbio();
-        return true;
-      }
+  if (!Https::init_client())
+    return false;
+
+  SSL_CTX_set_session_cache_mode(ctx,
+    SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  ::SSL_CTX_sess_set_new_cb(ctx, newsess);
+  if (!init() || !set_hostname(HOST) ||
+      (alpn.size() && ::SSL_set_alpn_protos(ssl,
+        reinterpret_cast<const unsigned char *>(alpn.data()), alpn.size())))
+    return false;
+  // Offer the cached session for an abbreviated handshake
+  sesskey = std::string { HOST } + ":" + peerport(Http::sockfd);
+  SSL_set_app_data(ssl, this);
+  ::SSL_SESSION *sess { SessionCache::get(sesskey) };
+  if (sess) {
+    ::SSL_set_session(ssl, sess);
+    ::SSL_SESSION_free(sess);
   }
 
-  return false;
+  set_connect_state();
+  if (!set_fd(Http::sockfd) || !do_handshake())
+    return false;
+  SessionCache::count(sess && ::SSL_session_reused(ssl));
+  return init_rwbio();
+}
+
+bool sockpp::Https::fill(const int TOMS) {
+  const auto ROOM { compact() };
+  if (!ROOM)
+    return false;
+  else if (ktls) {
+    if (!::SSL_has_pending(ssl) && !pollin(TOMS))
+      return false;
+    const auto N { ::SSL_read(ssl, rbuf.data() + rlen, ROOM) };
+    rlen += std::max(N, 0);
+    eof = N < 1 && ::SSL_get_error(ssl, N) != SSL_ERROR_WANT_READ;
+    return N > 0;
+  }
+
+  char buffer[sockpp::SBN];
+  while (1) {
+    // Drain records already buffered in the read BIO before polling
+    if (const auto N { ::SSL_read(ssl, rbuf.data() + rlen, ROOM) }; N > 0) {
+      rlen += N;
+      return true;
+    } else if (::SSL_get_error(ssl, N) != SSL_ERROR_WANT_READ) {
+        eof = true;
+        return false;
+    }
+
+    ssize_t Nenc { };
+    if (!pollin(TOMS) || (Nenc = readfd(sockfd, buffer, sizeof buffer, eof)) < 1)
+      return false;
+    else if (::BIO_write(r, buffer, Nenc) < 1) {
+      eof = true;
+      return false;
+    }
+  }
 }
 
+// Encrypt up to WBN of plaintext at a time into the write BIO, then send
+// the records it holds with one socket write straight from the BIO memory
 bool sockpp::Https::write(const std::string &req) const {
-  char buffer[sockpp::SBN] { };
-  ssize_t Nenc { };
-  return ::SSL_write(ssl, req.c_str(), req.size()) > 0 &&
-    (Nenc = ::BIO_read(w, buffer, sizeof buffer)) > 0 &&
-      ::write(sockfd, buffer, Nenc) > 0;
+  if (ktls)
+    return ::SSL_write(ssl, req.data(), req.size()) == static_cast<int>(req.size());
+
+  for (std::size_t i { }; i < req.size();) {
+    const auto N { ::SSL_write(ssl, req.data() + i,
+      std::min<std::size_t>(req.size() - i, WBN)) };
+    if (N < 1)
+      return false;
+
+    i += N;
+    char *p { };
+    if (const auto Nenc { BIO_get_mem_data(w, &p) };
+        Nenc < 1 || !sendraw(p, Nenc))
+      return false;
+    (void) BIO_reset(w);
+  }
+
+  return true;
+}
+
+// Spans are encrypted in turn into the write BIO, which is sent whenever
+// it holds WBN of plaintext and once after the last span
+bool sockpp::Https::write(const std::vector<std::string_view> &V, const bool) const {
+  std::size_t batch { };
+  const auto send {
+    [&](void) -> bool {
+      char *p { };
+      if (const auto Nenc { BIO_get_mem_data(w, &p) }; Nenc < 1 || !sendraw(p, Nenc))
+        return false;
+      (void) BIO_reset(w);
+      batch = 0;
+      return true;
+    }
+  };
+
+  for (const auto &P : V)
+    for (std::size_t i { }; i < P.size();) {
+      const auto L { std::min<std::size_t>(P.size() - i, ktls ? P.size() - i : WBN - batch) };
+      if (::SSL_write(ssl, P.data() + i, L) != static_cast<int>(L))
+        return false;
+
+      i += L;
+      if (!ktls && (batch += L) == WBN && !send())
+        return false;
+    }
+
+  return ktls || !batch || send();
+}
+
+// Records are staged for flush(). With kTLS the kernel encrypts as
+// SSL_write sends, which waits for the socket.
+bool sockpp::Https::queue(const std::string_view P) {
+  if (ktls)
+    return ::SSL_write(ssl, P.data(), P.size()) == static_cast<int>(P.size());
+
+  for (std::size_t i { }; i < P.size();) {
+    const auto N { ::SSL_write(ssl, P.data() + i, std::min<std::size_t>(P.size() - i, WBN)) };
+    if (N < 1)
+      return false;
+
+    i += N;
+    char *p { };
+    if (const auto Nenc { BIO_get_mem_data(w, &p) }; Nenc > 0)
+      wbuf.append(p, Nenc);
+    (void) BIO_reset(w);
+  }
+
+  return true;
+}
+
+// With kTLS the kernel encrypts file pages in place, else the file is read
+// through and encrypted in userspace
+bool sockpp::Https::sendfile(const int FD, ::off_t off, std::size_t l) const {
+  while (ktls && l)
+    if (const auto N { ::SSL_sendfile(ssl, FD, off, l, 0) }; N > 0) {
+      off += N;
+      l -= N;
+    } else
+        return false;
+
+  std::string buffer;
+  while (l) {
+    buffer.resize(std::min<std::size_t>(l, WBN));
+    if (const auto N { ::pread(FD, buffer.data(), buffer.size(), off) }; N > 0) {
+      buffer.resize(N);
+      if (!write(buffer))
+        return false;
+      off += N;
+      l -= N;
+    } else
+        return false;
+  }
+
+  return true;
+}
+
+// ALPN protocol selected by the server, empty if none
+std::string_view sockpp::Https::protocol(void) const {
+  const unsigned char *p { };
+  unsigned l { };
+  ::SSL_get0_alpn_selected(ssl, &p, &l);
+  return { reinterpret_cast<const char *>(p), l };
 }
 
 void sockpp::Https::certinfo(std::string &cipherinfo, std::string &cert, std::string &iss) const {
@@ -161,253 +753,1221 @@ void sockpp::Https::certinfo(std::string &cipherinfo, std::string &cert, std::st
   ::X509_free(server_cert);
 }
 
+// Accumulate a line, returning the bytes consumed up to its LF if complete
+std::size_t sockpp::Response::feedline(const std::string_view P) {
+  const auto *const LF { scan(P.data(), P.data() + P.size(), '\n') };
+  if (LF == P.data() + P.size()) {
+    line.append(P);
+    return 0;
+  }
+
+  line.append(P.data(), LF);
+  return LF - P.data() + 1;
+}
+
+std::size_t sockpp::Response::feed(Handle::Xfr &h, const std::string_view P) {
+  std::size_t i { };
+  while (i < P.size() && st != ST::DONE) {
+    const auto Q { P.substr(i) };
+    switch (st) {
+      case ST::HDR:
+        i += h.header().feed(Q);
+        if (h.header().complete()) {
+          if (h.header().ischkd())
+            st = ST::SIZE;
+          else if ((l = h.header().contentlen()))
+            st = ST::BODY;
+          else
+            st = ST::DONE;
+        }
+        break;
+      case ST::BODY:
+      case ST::DATA: {
+        const auto N { std::min(l, Q.size()) };
+        h.writercb()(Q.substr(0, N));
+        i += N;
+        if (!(l -= N))
+          st = st == ST::BODY ? ST::DONE : ST::DATAEND;
+        break;
+      }
+      case ST::SIZE:
+      case ST::DATAEND:
+      case ST::TRAILER:
+        if (const auto N { feedline(Q) }; !N)
+          i = P.size();
+        else {
+          i += N;
+          if (st == ST::DATAEND)
+            // CRLF trailing the chunk
+            st = ST::SIZE;
+          else if (st == ST::TRAILER) {
+            if (line.empty() || line == "\r")
+              st = ST::DONE;
+          } else if (!parsehex(line, l)) {
+            err = true;
+            st = ST::DONE;
+          } else
+              st = l ? ST::DATA : ST::TRAILER;
+          line.clear();
+        }
+        break;
+      case ST::DONE:
+        break;
+    }
+  }
+
+  return i;
+}
+
+using Hexline = std::array<char, 2 * sizeof(std::size_t) + 2>;
+
+// Chunk size line for L, formatted into HEX
+static std::string_view chunkline(Hexline &hex, const std::size_t L) {
+  auto *const END { std::to_chars(hex.data(), hex.data() + hex.size() - 2, L, 16).ptr };
+  std::copy_n("\r\n", 2, END);
+  return { hex.data(), static_cast<std::size_t>(END + 2 - hex.data()) };
+}
+
+// Length of the body of REQ, either held or referenced by it
+static std::size_t bodylen(const sockpp::Handle::Req &REQ) {
+  if (const auto *range { std::get_if<sockpp::Handle::Range>(&REQ.BODY) })
+    return range->LEN;
+  else if (const auto *span { std::get_if<std::string_view>(&REQ.BODY) })
+    return span->size();
+  return REQ.DATA.size();
+}
+
+// Where the body of REQ is held or referenced, if at all, and never for GET
+static bool isvalid(const sockpp::Meth METH, const sockpp::Handle::Req &REQ) {
+  const auto N { !REQ.DATA.empty() + !!REQ.BODY.index() + !!REQ.SRC };
+  return N < 2 && !(METH == sockpp::Meth::GET && N);
+}
+
+// Per-issue headers and the blank line, framing the body of REQ
+static std::string reqtail(const std::vector<std::string> &HEAD, const sockpp::Handle::Req &REQ) {
+  std::string tail;
+  for (const auto &h : HEAD)
+    tail.append(h).append("\r\n");
+  if (REQ.SRC)
+    tail.append("Transfer-Encoding: chunked\r\n");
+  else if (const auto L { bodylen(REQ) }; L)
+    tail.append("Content-Length: ").append(std::to_string(L)).append("\r\n");
+  return tail.append("\r\n");
+}
+
+// Prefix empty where the method is invalid
 template<typename S>
-bool sockpp::Send<S>::req(S &s, const std::string &HOST, const Handle::Req &req) const {
-  if (&METHSTR[static_cast<int>(req.METH)] > &METHSTR[METHSTR.size() - 1] ||
-      (req.METH == Meth::GET && req.DATA.size()))
-    return false;
-  
-  std::string request { 
-    METHSTR[static_cast<int>(req.METH)] + " " + req.ENDP + " " +
-      "HTTP/1.1" + "\r\n" +
-        "Host: " + HOST + "\r\n" +
-          "User-Agent: " + AGENT + "\r\n" +
-            "Accept: */*" + "\r\n" 
-    };
+sockpp::Handle::Prepared sockpp::Send<S>::prepare(const std::string &HOST, const Handle::Req &req) const {
+  if (static_cast<std::size_t>(req.METH) >= METHSTR.size())
+    return { req.METH, { } };
 
+  std::string prefix;
+  prefix.append(METHSTR[static_cast<int>(req.METH)]).append(" ").append(req.ENDP)
+    .append(" HTTP/1.1\r\nHost: ").append(HOST)
+      .append("\r\nUser-Agent: ").append(AGENT)
+        .append("\r\nAccept: */*\r\n");
   for (const auto &h : req.HEAD)
-    request += h + "\r\n";
+    prefix.append(h).append("\r\n");
+  return { req.METH, std::move(prefix) };
+}
 
-  if (req.DATA.size())
-    request += "Content-Length: " + std::to_string(req.DATA.size()) +
-      "\r\n\r\n" + req.DATA;
+// Request message, empty where the request is invalid or its body streamed
+template<typename S>
+std::string sockpp::Send<S>::str(const std::string &HOST, const Handle::Req &req) const {
+  if (!isvalid(req.METH, req) || req.BODY.index() || req.SRC)
+    return { };
+  
+  const auto PREPARED { prepare(HOST, req) };
+  if (PREPARED.PREFIX.empty())
+    return { };
 
-  request += "\r\n";
-  return s.write(request);
+  return PREPARED.PREFIX + reqtail({ }, req) + req.DATA;
 }
 
+// The body is written from where the Req holds or references it, never
+// copied into the message. A chunk is read from a source only once the
+// previous one is sent, and a file range is sent as the socket drains.
 template<typename S>
-bool sockpp::Recv<S>::ischkd(const std::string &HDR) const {
-  std::smatch match { };
-  return std::regex_search(HDR, match, RGX.TE) &&
-    std::regex_match(HDR.substr(match.prefix().length() + 19, 7), RGX.CHKD);
+bool sockpp::Send<S>::send(S &s, const Handle::Prepared &P, const std::vector<std::string> &HEAD, const Handle::Req &req) const {
+  const auto &PREFIX { P.PREFIX };
+  if (PREFIX.empty() || !isvalid(P.METH, req))
+    return false;
+
+  const auto TAIL { reqtail(HEAD, req) };
+  if (req.SRC) {
+    if (!s.write({ PREFIX, TAIL }))
+      return false;
+    Hexline hex;
+    for (std::string_view P; (P = req.SRC()).size();)
+      if (!s.write({ chunkline(hex, P.size()), P, "\r\n" }))
+        return false;
+
+    return s.write(std::string { "0\r\n\r\n" });
+  } else if (const auto *range { std::get_if<Handle::Range>(&req.BODY) })
+    return s.writemore(PREFIX + TAIL) && s.sendfile(range->FD, range->OFF, range->LEN);
+  else if (const auto *span { std::get_if<std::string_view>(&req.BODY) })
+    return s.write({ PREFIX, TAIL, *span });
+  return s.write({ PREFIX, TAIL, req.DATA });
 }
 
 template<typename S>
-bool sockpp::Recv<S>::reqhdr(S &s, std::string &hdr) const {
-  char p { };
-  while (s.pollin(TOMS) && s.read(p)) {
-    s.readfilter(p);
-    while (s.postread(p)) {
-      hdr += p;
-      if (static_cast<ssize_t>(hdr.rfind("\r\n\r\n")) > -1)
-        return true;
-    }
-  }
+bool sockpp::Send<S>::req(S &s, const std::string &HOST, const Handle::Req &req) const {
+  return send(s, prepare(HOST, req), { }, req);
+}
 
-  return false;
+template<typename S>
+bool sockpp::Send<S>::req(S &s, const Handle::Prepared &P, const Handle::Req &req) const {
+  return send(s, P, req.HEAD, req);
 }
 
 template<typename S>
-std::size_t sockpp::Recv<S>::parsecl(const std::string &HDR) const {
-  std::size_t l { };
-  std::smatch match { };
-  if (std::regex_search(HDR, match, RGX.CL) &&
-      (l = std::stoull(HDR.substr(match.prefix().length() + 16,
-        HDR.substr(match.prefix().length() + 16).find("\r\n")))));
+bool sockpp::Recv<S>::ischkd(const std::string &HDR) const {
+  return Header { HDR }.ischkd();
+}
+
+template<typename S>
+bool sockpp::Recv<S>::reqhdr(S &s, Header &hdr) const {
+  std::string_view P;
+  while (!hdr.complete() && (P = s.peek(TOMS)).size())
+    s.consume(hdr.feed(P));
 
-  return l;
+  return hdr.complete();
 }
 
 template<typename S>
-bool sockpp::Recv<S>::reqbody(S &s, const Client_cb &CB, std::size_t l) const {
-  char p { };
-  while (l && s.postread(p)) {
-    CB(p);
-    l--;
-  }
+bool sockpp::Recv<S>::reqhdr(S &s, std::string &hdr) const {
+  Header header;
+  const auto R { reqhdr(s, header) };
+  hdr += header.str();
+  return R;
+}
 
-  if (!l)
-    return true;
+template<typename S>
+std::size_t sockpp::Recv<S>::parsecl(const std::string &HDR) const {
+  return Header { HDR }.contentlen();
+}
 
-  while (l && s.pollin(TOMS) && s.read(p)) {
-    s.readfilter(p);
-    while (l && s.postread(p)) {
-      CB(p);
-      l--;
-    }
+template<typename S>
+bool sockpp::Recv<S>::reqbody(S &s, const Client_span_cb &CB, std::size_t l) const {
+  std::string_view P;
+  while (l && (P = s.read(l, TOMS)).size()) {
+    CB(P);
+    l -= P.size();
   }
 
   return !l;
 }
 
 template<typename S>
-bool sockpp::Recv<S>::reqchkd(S &s, const Client_cb &CB) const {
+bool sockpp::Recv<S>::reqchkd(S &s, const Client_span_cb &CB) const {
   char p { };
   std::string len;
-  std::smatch match { };
-  while (s.pollin(TOMS) && s.read(p)) {
-    s.readfilter(p);
-    while (s.postread(p)) {
+  std::size_t L { };
+  while (s.read(p, TOMS)) {
+    if (p != '\n') {
       len += p;
-      if (std::regex_search(len, match, RGX.CHKDHDR)) {
-        try {
-          if (const auto L { std::stoull(len, nullptr, 16) }; L) {
-            reqbody(s, CB, L);
-            len.clear();
-          } else
-              return true;
-        } catch (...) {
-          return false;
-        }
-      }
-    }
+      continue;
+    } else if (len.empty() || len == "\r")
+      // CRLF trailing the previous chunk
+      ;
+    else if (!parsehex(len, L))
+      return false;
+    else if (!L)
+      break;
+    else if (!reqbody(s, CB, L))
+      return false;
+
+    len.clear();
   }
 
+  // Trailer up to the empty line, leaving the connexion at the next request
+  len.clear();
+  while (s.read(p, TOMS))
+    if (p != '\n')
+      len += p;
+    else if (len.empty() || len == "\r")
+      return true;
+    else
+      len.clear();
+
   return false;
 }
 
 template<typename S>
-void sockpp::Recv<S>::reqchkd_raw(S &s, const Client_cb &CB) const {
-  char p { };
-  while (s.pollin(TOMS) && s.read(p)) {
-    s.readfilter(p);
-    while (s.postread(p))
-      CB(p);
-  }
+void sockpp::Recv<S>::reqchkd_raw(S &s, const Client_span_cb &CB) const {
+  std::string_view P;
+  while ((P = s.read(RBN, TOMS)).size())
+    CB(P);
 }
 
 template<typename S>
-sockpp::Client<S>::Client(const char HOST[], const char PORT[]) : 
-  HOST { std::string { HOST } } {
-  if (sock.Http::init_client(HOST, PORT) && sock.connect(HOST))
-    sock.init_poll();
-  else
-    throw std::runtime_error("Unable to connect");
+sockpp::Reply<S>::Reply(S &sock, const unsigned STATUS, const std::string_view REASON) : sock { sock } {
+  buf.append("HTTP/1.1 ").append(std::to_string(STATUS)).append(" ").append(REASON).append("\r\n");
 }
 
 template<typename S>
-bool sockpp::Client<S>::performreq(Handle::Xfr &h, const unsigned TOMS) {
-  Send<S> send;
-  Recv<S> recv { TOMS };
-  if (send.req(sock, HOST, h.req())) {
-    h.setres();
-    if (recv.reqhdr(sock, h.header()) && recv.ischkd(h.header()))
-      return recv.reqbody(sock, h.writercb());
-    else if (const auto L { recv.parsecl(h.header()) }; L)
-      return recv.reqbody(sock, h.writercb(), L);
-    }
+bool sockpp::Reply<S>::field(const std::string_view NAME, const std::string_view VALUE) {
+  if (body)
+    return false;
 
-  return false;
+  buf.append(NAME).append(": ").append(VALUE).append("\r\n");
+  return true;
 }
 
 template<typename S>
-sockpp::MultiClient<S>::MultiClient(const char HOST[], const char PORT[], const unsigned N) : 
+bool sockpp::Reply<S>::length(const std::size_t L) {
+  if (body)
+    return false;
+
+  buf.append("Content-Length: ").append(std::to_string(L)).append("\r\n\r\n");
+  data = buf.size();
+  return (body = true);
+}
+
+template<typename S>
+bool sockpp::Reply<S>::chunked(void) {
+  if (body)
+    return false;
+
+  buf.append("Transfer-Encoding: chunked\r\n\r\n");
+  data = buf.size();
+  return (chkd = body = true);
+}
+
+// One gather write of what is held: the header or the end of the previous
+// chunk, then the body data held and P, framed as a single chunk
+template<typename S>
+bool sockpp::Reply<S>::send(const std::string_view P, const bool LAST, const bool MORE) {
+  if (err)
+    return false;
+
+  const std::string_view HEAD { buf.data(), data }, DATA { buf.data() + data, buf.size() - data };
+  Hexline hex;
+  std::vector<std::string_view> V { HEAD };
+  if (chkd && DATA.size() + P.size())
+    V.insert(V.end(), { chunkline(hex, DATA.size() + P.size()), DATA, P, "\r\n" });
+  else
+    V.insert(V.end(), { DATA, P });
+  if (chkd && LAST)
+    V.emplace_back("0\r\n\r\n");
+
+  err = !sock.write(V, MORE);
+  buf.clear();
+  data = 0;
+  return !err;
+}
+
+// Data beyond what the buffer holds leaves at once, together with it
+template<typename S>
+bool sockpp::Reply<S>::write(const std::string_view P) {
+  if (!body || err)
+    return false;
+  else if (buf.size() + P.size() > LIMIT)
+    return send(P);
+
+  buf.append(P);
+  return true;
+}
+
+template<typename S>
+bool sockpp::Reply<S>::sendfile(const int FD, const ::off_t OFF, const std::size_t L) {
+  if (!body || err || !L)
+    return !err && body;
+
+  Hexline hex;
+  if (!send({ }, false, true) || (chkd && !sock.writemore(std::string { chunkline(hex, L) })) ||
+      !sock.sendfile(FD, OFF, L))
+    return !(err = true);
+  // The chunk ends ahead of whatever follows
+  if (chkd) {
+    buf.append("\r\n");
+    data = buf.size();
+  }
+
+  return true;
+}
+
+template<typename S>
+sockpp::Client<S>::Client(const char HOST[], const char PORT[], const bool KTLS, const Sockopts &OPTS) : 
   HOST { std::string { HOST } } {
-  if (N > MAXN)
-    throw std::runtime_error("# of requested connexions exceeds supremum");
-  
-  for (auto i { 0U }; i < N; i++) {
-    S &sock { SOCK[i] };
-    if (sock.Http::init_client(HOST, PORT) && sock.connect(HOST)) {
-      sock.init_poll();
-      C[i] = 1;
-    }
+  sock.set_ktls(KTLS);
+  if (sock.Http::init_client(HOST, PORT, OPTS) && sock.connect(HOST))
+    sock.init_poll();
+  else
+    throw std::runtime_error("Unable to connect");
+}
+
+template<typename S>
+bool sockpp::Client<S>::response(Handle::Xfr &h, const unsigned TOMS) {
+  Recv<S> recv { TOMS };
+  h.setres();
+  if (recv.reqhdr(sock, h.header()) && h.header().ischkd())
+    return recv.reqbody(sock, h.writercb());
+  else if (const auto L { h.header().contentlen() }; L)
+    return recv.reqbody(sock, h.writercb(), L);
+
+  return false;
+}
+
+template<typename S>
+bool sockpp::Client<S>::performreq(Handle::Xfr &h, const unsigned TOMS) {
+  return Send<S> { }.req(sock, HOST, h.req()) && response(h, TOMS);
+}
+
+template<typename S>
+bool sockpp::Client<S>::performreq(const Handle::Prepared &P, Handle::Xfr &h, const unsigned TOMS) {
+  return Send<S> { }.req(sock, P, h.req()) && response(h, TOMS);
+}
+
+template<typename S>
+bool sockpp::Client<S>::performreq(const std::vector<std::reference_wrapper<Handle::Xfr>> &H, const unsigned TOMS) {
+  Send<S> send;
+  std::string batch;
+  for (auto &h : H)
+    if (const auto REQUEST { send.str(HOST, h.get().req()) }; REQUEST.size())
+      batch += REQUEST;
+    else
+      return false;
+
+  if (!sock.write(batch))
+    return false;
+
+  // Responses arrive in the order of the requests
+  for (auto &h : H) {
+    h.get().setres();
+    Response res;
+    std::string_view P;
+    while (!res.done() && (P = sock.peek(TOMS)).size())
+      sock.consume(res.feed(h, P));
+    if (!res.done() || res.fail())
+      return false;
   }
-  
-  if (!C.any())
+
+  return true;
+}
+
+template<typename S>
+sockpp::MultiClient<S>::MultiClient(const char HOST[], const char PORT[], const unsigned N, const Sockopts &OPTS) : 
+  HOST { std::string { HOST } }, PORT { std::string { PORT } }, OPTS { OPTS }, SOCK(N) {
+  if (!reconnect())
     throw std::runtime_error("Unable to connect");
 }
 
 template<typename S>
-bool sockpp::MultiClient<S>::performreq(const std::vector<std::reference_wrapper<Handle::Xfr>> &H, const unsigned TOMS) {
-  std::vector<SockH> SH;
-  for (auto i { 0U }, j { 0U }; i < MAXN; i++)
-    if (C[i])
-      SH.emplace_back(SockH { SOCK[i], H[j++] });
+bool sockpp::MultiClient<S>::connect(std::unique_ptr<S> &sock) {
+  sock = std::make_unique<S>();
+  if (sock->Http::init_client(HOST.c_str(), PORT.c_str(), OPTS) && sock->connect(HOST.c_str())) {
+    sock->init_poll();
+    return true;
+  }
+
+  sock.reset();
+  return false;
+}
+
+// Reopen failed connexions, returns the # of connexions open. Up to
+// MAXCONNECTING threads, the caller among them, take the failed ones in
+// turn. Where no further thread can be started the caller carries on.
+template<typename S>
+std::size_t sockpp::MultiClient<S>::reconnect(void) {
+  std::vector<std::unique_ptr<S> *> failed;
+  for (auto &sock : SOCK)
+    if (!sock)
+      failed.push_back(&sock);
 
+  std::atomic<std::size_t> next { };
+  const auto WORK {
+    [this, &failed, &next](void) {
+      for (std::size_t i { }; (i = next++) < failed.size();)
+        connect(*failed[i]);
+    }
+  };
+
+  std::vector<std::thread> T;
+  try {
+    while (T.size() + 1 < std::min<std::size_t>(failed.size(), MAXCONNECTING))
+      T.emplace_back(WORK);
+  } catch (const std::system_error &) { }
+  WORK();
+  for (auto &t : T)
+    t.join();
+  return cnxcount();
+}
+
+template<typename S>
+bool sockpp::MultiClient<S>::performreq(const std::vector<std::reference_wrapper<Handle::Xfr>> &H, const unsigned TOMS) {
+  if (!reconnect())
+    return false;
+  
   Send<S> send;
-  for (auto sh { SH.begin() }; sh < SH.end();) {
-    if (send.req(sh->sock.get(), HOST, sh->h.get().req())) {
-      sh->h.get().setres();
-      sh++;
+  std::vector<SockH> SH(SOCK.size(), SockH { nullptr, { } });
+  std::vector<struct ::pollfd> P(SOCK.size(), ::pollfd { -1, POLLIN, 0 });
+  std::size_t next { }, n { }, ok { };
+  // Issue the next queued transfer on idle connexion I, reopening it where
+  // the peer closed it meanwhile
+  auto assign { [&](const std::size_t I) {
+    SH[I].h = nullptr;
+    P[I].fd = -1;
+    while (next < H.size()) {
+      if (auto &sock { SOCK[I] }; (!sock || (sock->peek(0), sock->iseof())) && !connect(sock))
+        return;
+      Handle::Xfr &h { H[next++].get() };
+      if (send.req(*SOCK[I], HOST, h.req())) {
+        h.setres();
+        SH[I] = SockH { &h, { } };
+        P[I].fd = SOCK[I]->get_fd();
+        n++;
+        return;
+      }
+
+      SOCK[I].reset();
+    }
+  } };
+  // Completed transfer on connexion I, or failed where the peer closed
+  auto retire { [&](const std::size_t I, const bool OK) {
+    n--;
+    if (OK) {
+      ok++;
+      if (SH[I].h->header().isclose())
+        SOCK[I].reset();
     } else
-        SH.erase(sh);
+        SOCK[I].reset();
+    assign(I);
+  } };
+  // Consume what the socket holds without blocking, false on close or error
+  auto advance { [&](const std::size_t I) -> bool {
+    S &sock { *SOCK[I] };
+    std::string_view p;
+    while (!SH[I].res.done() && (p = sock.peek(0)).size())
+      sock.consume(SH[I].res.feed(*SH[I].h, p));
+    return !sock.iseof();
+  } };
+
+  for (auto i { 0U }; i < SOCK.size(); i++)
+    assign(i);
+
+  Time time;
+  const auto INITTIME { time.now() };
+  std::size_t elapsed { };
+  while (n && (elapsed = time.diffpt<std::chrono::milliseconds>(time.now(), INITTIME)) < TOMS) {
+    for (auto i { 0U }; i < SOCK.size(); i++)
+      // Data held in a connexion buffer raises no poll event
+      while (SH[i].h && SOCK[i]->buffered() && (advance(i), SH[i].res.done()))
+        retire(i, !SH[i].res.fail());
+
+    if (!n || ::poll(P.data(), P.size(), TOMS - elapsed) < 1)
+      break;
+
+    for (auto i { 0U }; i < SOCK.size(); i++)
+      if (P[i].fd > -1 && P[i].revents) {
+        if (const auto OPEN { advance(i) }; SH[i].res.done())
+          retire(i, !SH[i].res.fail());
+        else if (!OPEN)
+          retire(i, false);
+      }
   }
-  
-  if (!SH.size())
+
+  return ok == H.size();
+}
+
+template<typename S>
+sockpp::Pool<S>::Pool(const std::size_t MAXIDLE, const unsigned IDLETOMS) : 
+  MAXIDLE { MAXIDLE }, IDLETOMS { IDLETOMS } { }
+
+// An idle connexion to HOST:PORT, or a new one where none remains usable.
+// Readable or errored idle connexions were closed by the server.
+template<typename S>
+std::unique_ptr<S> sockpp::Pool<S>::get(const std::string &HOST, const std::string &PORT) {
+  const auto KEY { HOST + ":" + PORT };
+  std::unique_ptr<S> sock;
+  {
+    std::list<Idle> stale;
+    std::lock_guard<std::mutex> lock { mtx };
+    const auto NOW { Time { }.now() };
+    // Most recently used first
+    for (auto it { IDLE.end() }; it != IDLE.begin() && !sock;) {
+      const auto CUR { std::prev(it) };
+      if (CUR->key != KEY && CUR->expiry > NOW) {
+        it = CUR;
+        continue;
+      } else if (CUR->key == KEY && CUR->expiry > NOW &&
+          !CUR->sock->pollerr(0) && !CUR->sock->pollin(0))
+        sock = std::move(CUR->sock);
+      // Closed outside the lock
+      stale.splice(stale.end(), IDLE, CUR);
+    }
+  }
+
+  if (sock)
+    return sock;
+  sock = std::make_unique<S>();
+  if (sock->Http::init_client(HOST.c_str(), PORT.c_str()) && sock->connect(HOST.c_str())) {
+    sock->init_poll();
+    return sock;
+  }
+
+  return nullptr;
+}
+
+template<typename S>
+void sockpp::Pool<S>::put(const std::string &HOST, const std::string &PORT, std::unique_ptr<S> sock, const Header &HDR) {
+  if (!sock || sock->iseof() || sock->buffered() || HDR.isclose())
+    return;
+
+  const auto T { HDR.keepalive() };
+  const auto TOMS { T && T * 1000 < IDLETOMS ? T * 1000 : IDLETOMS };
+  std::list<Idle> evict;
+  std::lock_guard<std::mutex> lock { mtx };
+  IDLE.push_back({ HOST + ":" + PORT, std::move(sock),
+    Time { }.now() + std::chrono::milliseconds(TOMS) });
+  if (IDLE.size() > MAXIDLE)
+    evict.splice(evict.end(), IDLE, IDLE.begin());
+}
+
+template<typename S>
+bool sockpp::Pool<S>::performreq(const std::string &HOST, const std::string &PORT, Handle::Xfr &h, const unsigned TOMS) {
+  auto sock { get(HOST, PORT) };
+  if (!sock || !Send<S> { }.req(*sock, HOST, h.req()))
     return false;
 
-  Recv<S> recv { sockpp::MULTI_TOMS };
+  h.setres();
+  Response res;
+  std::string_view P;
+  while (!res.done() && (P = sock->peek(TOMS)).size())
+    sock->consume(res.feed(h, P));
+  if (!res.done() || res.fail())
+    return false;
+
+  put(HOST, PORT, std::move(sock), h.header());
+  return true;
+}
+
+template<typename S>
+std::size_t sockpp::Pool<S>::idlecount(void) {
+  std::lock_guard<std::mutex> lock { mtx };
+  return IDLE.size();
+}
+
+template<typename S>
+void sockpp::Pool<S>::clear(void) {
+  std::list<Idle> evict;
+  std::lock_guard<std::mutex> lock { mtx };
+  evict.swap(IDLE);
+}
+
+static constexpr std::array<std::string_view, 4> H2METH { "GET", "POST", "PUT", "DELETE" };
+
+// Big-endian 32 bit field
+static std::string be32(const std::uint32_t V) {
+  return { static_cast<char>(V >> 24), static_cast<char>(V >> 16), static_cast<char>(V >> 8),
+    static_cast<char>(V) };
+}
+
+sockpp::Http2::Http2(const char HOST[], const char PORT[], const bool TLS) : 
+  HOST { std::string { HOST } } {
+  if (TLS) {
+    auto https { std::make_unique<Https>() };
+    https->set_alpn("h2");
+    sock = std::move(https);
+  } else
+      sock = std::make_unique<Http>();
+  if (!sock->init_client(HOST, PORT) || !sock->connect(HOST))
+    throw std::runtime_error("Unable to connect");
+  else if (TLS && static_cast<const Https &>(*sock).protocol() != "h2")
+    throw std::runtime_error("Unable to negotiate h2");
+
+  sock->init_poll();
+  // Connexion preface, then the peer's SETTINGS precede any other frame
+  out = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+  std::string s;
+  // No server push, and our receive window
+  for (const auto &[ID, V] : { std::pair<std::uint16_t, std::uint32_t> { 0x2, 0 }, { 0x4, WINDOW } })
+    s += std::string { static_cast<char>(ID >> 8), static_cast<char>(ID) } + be32(V);
+  frame(SETTINGS, 0, 0, s);
+  frame(WINDOW_UPDATE, 0, 0, be32(WINDOW - 65535));
+  if (!sock->write(out))
+    throw std::runtime_error("Unable to write preface");
+  out.clear();
+  
   Time time;
   const auto INITTIME { time.now() };
-  while (SH.size() &&
-    time.diffpt<std::chrono::milliseconds>(time.now(), INITTIME) < TOMS) {
-    for (auto sh { SH.begin() }; sh < SH.end();)
-      if (recv.reqhdr(sh->sock.get(), sh->h.get().header())) {
-        if (recv.ischkd(sh->h.get().header()) && 
-              recv.reqbody(sh->sock.get(), sh->h.get().writercb()));
-        else if (const auto L { recv.parsecl(sh->h.get().header()) }; L &&
-            recv.reqbody(sh->sock.get(), sh->h.get().writercb(), L));
-        else
-          continue;
-        
-        SH.erase(sh);
+  std::size_t elapsed { };
+  while (!settings && (elapsed = time.diffpt<std::chrono::milliseconds>(time.now(), INITTIME)) < HANDSHAKE_TOMS)
+    if (!recv(HANDSHAKE_TOMS - elapsed))
+      break;
+  if (!settings)
+    throw std::runtime_error("No SETTINGS from peer");
+}
+
+sockpp::Http2::~Http2(void) {
+  if (isopen()) {
+    frame(GOAWAY, 0, 0, be32(0) + be32(0));
+    sock->write(out);
+  }
+}
+
+void sockpp::Http2::frame(const unsigned char TYPE, const unsigned char FLAGS, const std::uint32_t ID, const std::string_view P) {
+  out += { static_cast<char>(P.size() >> 16), static_cast<char>(P.size() >> 8),
+    static_cast<char>(P.size()), static_cast<char>(TYPE), static_cast<char>(FLAGS),
+      static_cast<char>(ID >> 24), static_cast<char>(ID >> 16), static_cast<char>(ID >> 8),
+        static_cast<char>(ID) };
+  out += P;
+}
+
+// Open a stream for the request of H, its header block split into frames
+// within the peer's frame size
+bool sockpp::Http2::open(Handle::Xfr &h) {
+  const auto &REQ { h.req() };
+  if (static_cast<std::size_t>(REQ.METH) >= H2METH.size() ||
+      (REQ.METH == Meth::GET && REQ.DATA.size()) || REQ.BODY.index() || REQ.SRC)
+    return false;
+
+  std::vector<Hpack::Field> fields {
+    { ":method", std::string { H2METH[static_cast<int>(REQ.METH)] } },
+    { ":scheme", dynamic_cast<const Https *>(sock.get()) ? "https" : "http" },
+    { ":authority", HOST },
+    { ":path", REQ.ENDP },
+    { "user-agent", "TCPRequest" },
+    { "accept", "*/*" }
+  };
+
+  // Field names are lowercase, connexion-specific fields do not apply
+  for (const auto &H : REQ.HEAD)
+    if (const auto COLON { H.find(':') }; COLON != std::string::npos) {
+      std::string name { H.substr(0, COLON) };
+      std::transform(name.begin(), name.end(), name.begin(),
+        [](const unsigned char c) { return std::tolower(c); });
+      if (name != "connection" && name != "keep-alive" && name != "transfer-encoding" &&
+          name != "upgrade" && name != "host" && name != "proxy-connection") {
+        const auto V { H.find_first_not_of(" \t", COLON + 1) };
+        fields.emplace_back(name, V == std::string::npos ? "" : H.substr(V));
+      }
+    }
+
+  if (REQ.DATA.size())
+    fields.emplace_back("content-length", std::to_string(REQ.DATA.size()));
+
+  const auto ID { nextid };
+  nextid += 2;
+  const auto BLOCK { enc.encode(fields) };
+  auto [it, _] { STREAMS.emplace(ID, Stream { &h, REQ.DATA, 0, peerwin }) };
+  const unsigned char ES { static_cast<unsigned char>(it->second.data.empty() ? END_STREAM : 0) };
+  std::string_view b { BLOCK };
+  auto N { std::min<std::size_t>(b.size(), peerframe) };
+  frame(HEADERS, ES | (N == b.size() ? END_HEADERS : 0), ID, b.substr(0, N));
+  for (b.remove_prefix(N); b.size(); b.remove_prefix(N)) {
+    N = std::min<std::size_t>(b.size(), peerframe);
+    frame(CONTINUATION, N == b.size() ? END_HEADERS : 0, ID, b.substr(0, N));
+  }
+
+  h.setres();
+  return true;
+}
+
+void sockpp::Http2::senddata(const std::uint32_t ID, Stream &s) {
+  while (s.sent < s.data.size() && sendwin > 0 && s.sendwin > 0) {
+    const auto N { std::min({ s.data.size() - s.sent, static_cast<std::size_t>(peerframe),
+      static_cast<std::size_t>(sendwin), static_cast<std::size_t>(s.sendwin) }) };
+    frame(DATA, s.sent + N == s.data.size() ? END_STREAM : 0, ID,
+      std::string_view { s.data }.substr(s.sent, N));
+    s.sent += N;
+    sendwin -= N;
+    s.sendwin -= N;
+  }
+}
+
+// Header block complete: the response header, else trailers. Every block
+// is decoded to keep the HPACK table in step.
+bool sockpp::Http2::endheaders(void) {
+  std::vector<Hpack::Field> fields;
+  const auto ID { blockid };
+  blockid = 0;
+  if (!dec.decode(block, fields))
+    return false;
+  
+  block.clear();
+  const auto it { STREAMS.find(ID) };
+  if (it == STREAMS.end())
+    return true;
+
+  auto &s { it->second };
+  if (!s.hdr) {
+    std::string status;
+    std::string hdr;
+    for (const auto &[NAME, V] : fields)
+      if (NAME == ":status")
+        status = V;
+      else if (NAME.size() && NAME[0] != ':')
+        hdr += NAME + ": " + V + "\r\n";
+    // Informational responses precede the final one
+    if (status.size() == 3 && status[0] == '1')
+      return true;
+    s.h->header() = Header { "HTTP/2 " + status + "\r\n" + hdr + "\r\n" };
+    s.hdr = true;
+  }
+
+  if (blockend)
+    s.done = true;
+  return true;
+}
+
+static std::uint32_t get32(const std::string_view P) {
+  return static_cast<std::uint32_t>(static_cast<unsigned char>(P[0])) << 24 |
+    static_cast<unsigned char>(P[1]) << 16 | static_cast<unsigned char>(P[2]) << 8 |
+      static_cast<unsigned char>(P[3]);
+}
+
+// Act on a frame, false on a connexion error
+bool sockpp::Http2::dispatch(const unsigned char TYPE, const unsigned char FLAGS, const std::uint32_t ID, std::string_view p) {
+  const auto L { p.size() };
+  const auto it { STREAMS.find(ID) };
+  if (block.size() || blockid) {
+    // A header block admits only its CONTINUATION frames
+    if (TYPE != CONTINUATION || ID != blockid)
+      return false;
+    block += p;
+    return !(FLAGS & END_HEADERS) || endheaders();
+  }
+
+  if ((TYPE == DATA || TYPE == HEADERS) && (FLAGS & PADDED)) {
+    if (p.empty() || static_cast<unsigned char>(p[0]) >= p.size())
+      return false;
+    p = p.substr(1, p.size() - 1 - static_cast<unsigned char>(p[0]));
+  }
+
+  switch (TYPE) {
+    case DATA:
+      if (!ID)
+        return false;
+      if (it != STREAMS.end() && it->second.hdr && !it->second.done) {
+        auto &s { it->second };
+        s.h->writercb()(p);
+        s.done = FLAGS & END_STREAM;
+        if ((s.recvd += L) >= WINDOW / 2 && !s.done) {
+          frame(WINDOW_UPDATE, 0, ID, be32(s.recvd));
+          s.recvd = 0;
+        }
+      }
+      if ((recvd += L) >= WINDOW / 2) {
+        frame(WINDOW_UPDATE, 0, 0, be32(recvd));
+        recvd = 0;
+      }
+      return true;
+    case HEADERS:
+      if (!ID || ((FLAGS & PRIO) && p.size() < 5))
+        return false;
+      block = p.substr(FLAGS & PRIO ? 5 : 0);
+      blockend = FLAGS & END_STREAM;
+      blockid = ID;
+      return !(FLAGS & END_HEADERS) || endheaders();
+    case RST_STREAM:
+      if (L != 4) {
+        error = FRAME_SIZE_ERROR;
+        return false;
+      } else if (!ID)
+        return false;
+      else if (it != STREAMS.end())
+        it->second.done = it->second.fail = true;
+      return true;
+    case SETTINGS:
+      if (FLAGS & ACK)
+        return true;
+      else if (ID || L % 6)
+        return false;
+      for (; p.size(); p.remove_prefix(6)) {
+        const auto SID { static_cast<unsigned char>(p[0]) << 8 | static_cast<unsigned char>(p[1]) };
+        const auto V { get32(p.substr(2)) };
+        if (SID == 0x1)
+          enc.set_limit(V);
+        else if (SID == 0x3)
+          peerstreams = V;
+        else if (SID == 0x4) {
+          if (V > INT32_MAX)
+            return false;
+          // The change applies to the windows of open streams
+          for (auto &[_, s] : STREAMS)
+            s.sendwin += static_cast<std::int64_t>(V) - peerwin;
+          peerwin = V;
+        } else if (SID == 0x5) {
+          if (V < 16384 || V > 16777215)
+            return false;
+          peerframe = V;
+        }
+      }
+      settings = true;
+      frame(SETTINGS, ACK, 0);
+      return true;
+    case PING:
+      if (L != 8) {
+        error = FRAME_SIZE_ERROR;
+        return false;
+      } else if (ID)
+        return false;
+      else if (!(FLAGS & ACK))
+        frame(PING, ACK, 0, p);
+      return true;
+    case GOAWAY:
+      if (L < 8)
+        return false;
+      goaway = true;
+      // Streams the peer will not process
+      for (auto &[SID, s] : STREAMS)
+        if (SID > (get32(p) & 0x7fffffff) && !s.done)
+          s.done = s.fail = true;
+      return true;
+    case WINDOW_UPDATE:
+      if (L != 4) {
+        error = FRAME_SIZE_ERROR;
+        return false;
+      } else if (const auto INC { get32(p) & 0x7fffffff }; !ID) {
+        // A zero increment is an error of the connexion, else of its stream
+        if (!INC)
+          return false;
+        sendwin += INC;
+      } else if (it == STREAMS.end());
+      else if (!INC) {
+        frame(RST_STREAM, 0, ID, be32(PROTOCOL_ERROR));
+        it->second.done = it->second.fail = true;
       } else
-          sh++;
+          it->second.sendwin += INC;
+      return true;
+    case PUSH_PROMISE:
+      // Disabled by our SETTINGS
+      return false;
+    case CONTINUATION:
+      return false;
+    default:
+      // Unknown frame types are ignored
+      return true;
   }
+}
+
+// Read and act on the frames available within TOMS, false on close,
+// timeout or connexion error
+bool sockpp::Http2::recv(const unsigned TOMS) {
+  const auto P { sock->peek(TOMS) };
+  if (P.empty())
+    return false;
+  in += P;
+  sock->consume(P.size());
+  std::size_t i { };
+  while (in.size() - i >= 9) {
+    const std::string_view F { in.data() + i, in.size() - i };
+    const std::size_t L { static_cast<std::size_t>(static_cast<unsigned char>(F[0])) << 16 |
+      static_cast<unsigned char>(F[1]) << 8 | static_cast<unsigned char>(F[2]) };
+    if (L > MAXFRAME) {
+      goaway = true;
+      return false;
+    } else if (F.size() < 9 + L)
+      break;
+    else if (!dispatch(F[3], F[4], get32(F.substr(5)) & 0x7fffffff, F.substr(9, L))) {
+      frame(GOAWAY, 0, 0, be32(0) + be32(error));
+      sock->write(out);
+      out.clear();
+      goaway = true;
+      return false;
+    }
 
+    i += 9 + L;
+  }
+
+  in.erase(0, i);
   return true;
 }
 
+bool sockpp::Http2::performreq(const std::vector<std::reference_wrapper<Handle::Xfr>> &H, const unsigned TOMS) {
+  std::size_t next { }, ok { };
+  auto active { [&](void) {
+    return std::count_if(STREAMS.begin(), STREAMS.end(),
+      [](const auto &S) { return !S.second.done; }); } };
+  Time time;
+  const auto INITTIME { time.now() };
+  std::size_t elapsed { };
+  while (isopen() && (elapsed = time.diffpt<std::chrono::milliseconds>(time.now(), INITTIME)) < TOMS) {
+    // Retire completed streams, then open as many as the peer admits
+    for (auto it { STREAMS.begin() }; it != STREAMS.end();)
+      if (it->second.done) {
+        ok += !it->second.fail && it->second.hdr;
+        it = STREAMS.erase(it);
+      } else
+          it++;
+    // A handle open() rejects is left failed, with an empty response
+    while (next < H.size() && STREAMS.size() < peerstreams)
+      if (auto &h { H[next++].get() }; !open(h))
+        h.setres();
+    for (auto &[ID, s] : STREAMS)
+      senddata(ID, s);
+    if (out.size()) {
+      if (!sock->write(out))
+        break;
+      out.clear();
+    }
+
+    if (!active() || !recv(TOMS - elapsed))
+      break;
+  }
+
+  // Cancel streams left incomplete
+  for (auto &[ID, s] : STREAMS)
+    if (!s.done)
+      frame(RST_STREAM, 0, ID, be32(CANCEL));
+    else
+      ok += !s.fail && s.hdr;
+  STREAMS.clear();
+  if (out.size() && isopen())
+    sock->write(out);
+  out.clear();
+  return ok == H.size();
+}
+
+static sockpp::Sockopts reuseport(const sockpp::Sockopts &OPTS, const bool REUSEPORT) {
+  auto opts { OPTS };
+  opts.reuseport |= REUSEPORT;
+  return opts;
+}
+
 template<typename S>
-sockpp::Server<S>::Server(const char PORT[]) {
-  if (sock.Http::init_server(PORT))
-    sock.init_poll();
-  else
+sockpp::Server<S>::Server(const char PORT[], const bool REUSEPORT, const char CERT[], const char KEY[]) :
+  Server { PORT, reuseport({ }, REUSEPORT), CERT, KEY } { }
+
+template<typename S>
+sockpp::Server<S>::Server(const char PORT[], const Sockopts &OPTS, const char CERT[], const char KEY[]) :
+  opts { OPTS } {
+  if (!reload(CERT, KEY))
+    throw std::runtime_error("Unable to load certificate");
+  else if (!sock.Http::init_server(PORT, OPTS) || (epfd = ::epoll_create1(EPOLL_CLOEXEC)) < 0 ||
+      (sock.init_poll(), !ctl(EPOLL_CTL_ADD, sock.get_fd(), EPOLLIN))) {
+    // No destructor follows a throwing constructor
+    if (epfd > -1)
+      ::close(epfd);
+    if (ctx)
+      ::SSL_CTX_free(ctx);
     throw std::runtime_error("Unable to init server");
+  }
 }
-// Construct a server for each client
+
+template<typename S>
+sockpp::Server<S>::~Server(void) {
+  PEND.clear();
+  SOCK.clear();
+  ::close(epfd);
+  if (ctx)
+    ::SSL_CTX_free(ctx);
+}
+
+template<>
+bool sockpp::Server<sockpp::Http>::reload(const char [], const char []) {
+  return true;
+}
+// Established connexions hold their own reference to the context
+// they were accepted on, so the context is swapped in a single step
+template<>
+bool sockpp::Server<sockpp::Https>::reload(const char CERT[], const char KEY[]) {
+  ::SSL_CTX *next { Https::server_ctx(CERT, KEY) };
+  if (!next)
+    return false;
+
+  std::lock_guard<std::mutex> lock { ctxmtx };
+  std::swap(ctx, next);
+  if (next)
+    ::SSL_CTX_free(next);
+  return true;
+}
+
+template<typename S>
+bool sockpp::Server<S>::ctl(const int OP, const int FD, const unsigned EVENTS) {
+  struct ::epoll_event ev { };
+  ev.events = EVENTS;
+  ev.data.fd = FD;
+  return ::epoll_ctl(epfd, OP, FD, &ev) > -1;
+}
+
+template<typename S>
+void sockpp::Server<S>::insert(std::unique_ptr<S> server) {
+  const auto FD { server->get_fd() };
+  if (ctl(EPOLL_CTL_ADD, FD, EPOLLIN))
+    SOCK.emplace(FD, std::move(server));
+}
+
+template<typename S>
+void sockpp::Server<S>::erase(const int FD) {
+  ::epoll_ctl(epfd, EPOLL_CTL_DEL, FD, nullptr);
+  PEND.erase(FD);
+  SOCK.erase(FD);
+}
+
+template<>
+void sockpp::Server<sockpp::Http>::handshake(const int) { }
+// Advance a pending handshake as far as the socket allows without blocking
 template<>
-void sockpp::Server<sockpp::Http>::recv_client(const char [], const char []) {
-  auto server { std::make_unique<Http>(this->sock.accept()) };
+void sockpp::Server<sockpp::Https>::handshake(const int FD) {
+  const auto it { PEND.find(FD) };
+  if (it == PEND.end())
+    return;
+
+  auto &server { it->second.sock };
+  switch (server->handshake()) {
+    case HS::WANTR:
+      if (!ctl(EPOLL_CTL_MOD, FD, EPOLLIN))
+        erase(FD);
+      return;
+    case HS::WANTW:
+      if (!ctl(EPOLL_CTL_MOD, FD, EPOLLOUT))
+        erase(FD);
+      return;
+    case HS::FAIL:
+      erase(FD);
+      return;
+    case HS::DONE:
+      break;
+  }
+
+  if (!server->set_nonblock(false) || !ctl(EPOLL_CTL_MOD, FD, EPOLLIN) ||
+      !server->init_rwbio()) {
+    erase(FD);
+    return;
+  }
+
   server->init_poll();
-  SOCK.emplace_back(std::move(server));
+  SOCK.emplace(FD, std::move(server));
+  PEND.erase(it);
 }
 
+template<typename S>
+void sockpp::Server<S>::expire(void) {
+  Time time;
+  const auto NOW { time.now() };
+  while (PENDQ.size() &&
+      time.diffpt<std::chrono::milliseconds>(NOW, PENDQ.front().second) > HANDSHAKE_TOMS) {
+    // The descriptor may since have been closed and reused
+    if (const auto it { PEND.find(PENDQ.front().first) };
+        it != PEND.end() && it->second.t == PENDQ.front().second)
+      erase(it->first);
+    PENDQ.pop_front();
+  }
+}
+// Construct a server for each client
 template<>
-void sockpp::Server<sockpp::Https>::recv_client(const char CERT[], const char KEY[]) {
-  Https client;
-  if (!client.init_client() || !client.configure_ctx(CERT, KEY))
+void sockpp::Server<sockpp::Http>::recv_client(void) {
+  const auto FD { sock.accept() };
+  if (FD < 0)
     return;
 
+  auto server { std::make_unique<Http>(FD) };
+  server->set_opts(opts);
+  server->init_poll();
+  insert(std::move(server));
+}
+
+template<>
+void sockpp::Server<sockpp::Https>::recv_client(void) {
   const auto FD { sock.Http::accept() };
+  if (FD < 0)
+    return;
+
   auto server { std::make_unique<Https>(FD) };
-  if (server->init_server() && server->init()) {
-    server->set_ctx(client.get_ctx());
-    server->set_accept_state();
-    if (server->set_fd(FD) && server->do_handshake() &&
-      server->init_rbio() && server->init_wbio()) {
-        server->set_rwbio();
-        server->init_poll();
-        SOCK.emplace_back(std::move(server));
-    }
+  server->set_opts(opts);
+  server->set_ktls(ktls);
+  if (std::lock_guard<std::mutex> lock { ctxmtx }; !server->init(ctx))
+    return;
+  // Handshake proceeds from the event loop as the client responds
+  server->set_accept_state();
+  if (server->set_fd(FD) && server->set_nonblock(true) &&
+      ctl(EPOLL_CTL_ADD, FD, EPOLLIN)) {
+    const auto NOW { Time { }.now() };
+    PEND.emplace(FD, Pending { std::move(server), NOW });
+    PENDQ.emplace_back(FD, NOW);
   }
 }
 
+// Whether a complete request header is held by the connexion or arrives
+// without waiting. A partial one is left for the event loop to complete,
+// unless it fills the receive buffer, when the callback reads on.
+template<typename S>
+static bool ready(S &s) {
+  sockpp::Header hdr;
+  std::size_t n { };
+  for (auto P { s.peek(0) }; n < P.size(); P = s.peekmore(0))
+    if (n += hdr.feed(P.substr(n)); hdr.complete() || P.size() >= sockpp::RBN)
+      return true;
+  return false;
+}
+
+template<typename S>
+void sockpp::Server<S>::dispatch(const Server_cb<S> &CB, const int FD) {
+  const auto it { SOCK.find(FD) };
+  if (it == SOCK.end())
+    return;
+  // Service every request held in the connexion buffer before returning
+  // to the event loop, as they raise no further events
+  S &server { *it->second };
+  while (ready(server))
+    if (!CB(server)) {
+      erase(FD);
+      return;
+    }
+
+  if (server.iseof())
+    erase(FD);
+}
+
 template<typename S>
-void sockpp::Server<S>::run(const Server_cb<S> &CB, const char CERT[], const char KEY[]) {
+void sockpp::Server<S>::run(const Server_cb<S> &CB) {
+  std::array<struct ::epoll_event, MAXEV> events;
   while (!quit) {
-    if (poll_listen(10))
-      recv_client(CERT, KEY);
-    
-    for (auto i { 0U }; auto &sock : SOCK) {
-      if (sock->pollin(10) && !CB(*sock)) {
-        SOCK.erase(SOCK.begin() + i);
-        break;
-      }
+    const auto N { ::epoll_wait(epfd, events.data(), events.size(), 10) };
+    for (auto i { 0 }; i < N; i++) {
+      const auto FD { events[i].data.fd };
+      if (FD == sock.get_fd())
+        recv_client();
+      else if (PEND.count(FD))
+        handshake(FD);
+      else if (events[i].events & EPOLLIN)
+        dispatch(CB, FD);
+      else
+        // EPOLLERR or EPOLLHUP without data pending
+        erase(FD);
+    }
 
-      i++;
+    expire();
+  }
+}
+
+template<typename S>
+sockpp::MultiServer<S>::MultiServer(const char PORT[], const unsigned N, const char CERT[], const char KEY[]) :
+  MultiServer { PORT, N, Sockopts { }, CERT, KEY } { }
+
+template<typename S>
+sockpp::MultiServer<S>::MultiServer(const char PORT[], const unsigned N, const Sockopts &OPTS, const char CERT[], const char KEY[]) {
+  if (!N)
+    throw std::runtime_error("# of requested shards must be non-zero");
+
+  for (auto i { 0U }; i < N; i++)
+    SERVER.emplace_back(std::make_unique<Server<S>>(PORT, reuseport(OPTS, true), CERT, KEY));
+}
+
+template<typename S>
+bool sockpp::MultiServer<S>::reload(const char CERT[], const char KEY[]) {
+  bool r { true };
+  for (auto &server : SERVER)
+    r &= server->reload(CERT, KEY);
+  return r;
+}
+
+template<typename S>
+void sockpp::MultiServer<S>::run(const Server_cb<S> &CB, const bool PIN) {
+  const auto NCPU { std::max(std::thread::hardware_concurrency(), 1U) };
+  std::vector<std::thread> T;
+  for (auto i { 0U }; auto &server : SERVER) {
+    T.emplace_back([&server, &CB] { server->run(CB); });
+    if (PIN) {
+      ::cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      CPU_SET(i++ % NCPU, &cpuset);
+      ::pthread_setaffinity_np(T.back().native_handle(), sizeof cpuset, &cpuset);
     }
   }
+
+  for (auto &t : T)
+    t.join();
 }
@@ -25,58 +25,190 @@ SOFTWARE.
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <array>
 #include <vector>
 #include <atomic>
-#include <regex>
-#include <bitset>
 #include <variant>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <list>
+#include <future>
+#include <algorithm>
+#include <cstdint>
 #include <sys/socket.h>
 #include <openssl/ssl.h>
 #include <openssl/bio.h>
 #include <poll.h>
 #include <unistd.h>
+#include "header.h"
+#include "hpack.h"
+#include "time.h"
 
 namespace sockpp {
   // Timeout Milliseconds (TOMS)
   static constexpr unsigned SINGULAR_TOMS { 2000 };
   static constexpr unsigned MULTI_TOMS { 2500 };
+  static constexpr unsigned HANDSHAKE_TOMS { 5000 };
+  static constexpr unsigned CONNECT_TOMS { 5000 };
+  // Delay ahead of racing the next address (Happy Eyeballs)
+  static constexpr unsigned STAGGER_TOMS { 250 };
   // SSL BIO Buffer Size
   static constexpr unsigned SBN { 16384 };
+  // Receive Buffer Size
+  static constexpr unsigned RBN { 16384 };
+  // TLS Write Batch Size, plaintext encrypted per socket write
+  static constexpr unsigned WBN { 4 * SBN };
+  // Connexions a MultiClient opens concurrently
+  static constexpr unsigned MAXCONNECTING { 16 };
   static constexpr char CERT[] { "/tmp/cert.pem" };
   static constexpr char KEY[] { "/tmp/key.pem" };
 
+  // Socket options applied by init_client and init_server. Options left
+  // at 0 or false keep the system default.
+  struct Sockopts {
+    // Either end
+    bool nodelay { };  // TCP_NODELAY
+    bool quickack { };  // TCP_QUICKACK
+    int rcvbuf { }, sndbuf { };  // SO_RCVBUF, SO_SNDBUF bytes
+    int busypoll { };  // SO_BUSY_POLL microseconds
+    // Client: TCP_FASTOPEN_CONNECT where non-zero. Server: TFO queue length.
+    int fastopen { };
+    // Client
+    unsigned connect_toms { CONNECT_TOMS };
+    // Server
+    int backlog { SOMAXCONN };
+    bool reuseaddr { true }, reuseport { };
+    int deferaccept { };  // TCP_DEFER_ACCEPT seconds
+  };
+
   class Http {
-    char p { };
   protected:
     int sockfd { -1 };
     struct ::pollfd pollfd { };
+    // Receive buffer (plaintext), consumed from rpos to rlen
+    std::vector<char> rbuf;
+    std::size_t rpos { }, rlen { };
+    // Peer closed or read error
+    bool eof { };
+    // Output staged for non-blocking transmission, sent from wpos
+    std::string wbuf;
+    std::size_t wpos { };
+    // Move the unconsumed bytes to the front of rbuf, returning the room after
+    std::size_t compact(void);
+    // Socket write of bytes already in wire form, beneath any TLS layer
+    bool sendraw(const char [], std::size_t, const bool = false) const;
   public:
     Http(void) = default;
     explicit Http(const int FD) : sockfd { FD } { };
-    ~Http(void) { deinit(); }
-    bool init_client(const char [], const char []);
-    bool init_server(const char []);
+    virtual ~Http(void) { deinit(); }
+    bool init_client(const char [], const char [], const Sockopts & = { });
+    bool init_server(const char [], const Sockopts & = { });
     void deinit(void);
     void init_poll(void) { pollfd.fd = sockfd; }
+    int get_fd(void) const { return sockfd; }
+    bool set_nonblock(const bool);
+    // Options of an established connexion
+    bool set_opts(const Sockopts &) const;
     bool pollin(const int);
     bool pollout(const int);
     bool pollerr(const int);
     int accept(void) { return ::accept(sockfd, nullptr, nullptr); }
-    bool read(char &p) const {
-      return ::read(sockfd, &p, sizeof p) > 0; }
+    bool read(char &, const int);
+    std::string_view read(const std::size_t, const int);
+    std::string_view peek(const int);
+    // Unconsumed bytes with whatever arrives within TOMS appended
+    std::string_view peekmore(const int);
+    void consume(const std::size_t N) { rpos += N; }
+    virtual bool buffered(void) const { return rpos < rlen; }
+    bool iseof(void) const { return eof; }
+    virtual void set_ktls(const bool) { }
     virtual bool connect(const char []) { return true; }
-    virtual void readfilter(char p) { this->p = p; }
-    virtual bool postread(char &p) {
-      p = this->p; this->p = '\0'; return p; }
+    virtual bool fill(const int);
     virtual bool write(const std::string &req) const {
-      return ::write(sockfd, req.c_str(), req.size()) > 0; }
+      return sendraw(req.c_str(), req.size()); }
+    // Gather write of the spans in order, without joining them
+    virtual bool write(const std::vector<std::string_view> &, const bool = false) const;
+    // Write with further data to follow promptly
+    virtual bool writemore(const std::string &req) const {
+      return sendraw(req.c_str(), req.size(), true); }
+    virtual bool sendfile(const int, ::off_t, std::size_t) const;
+    bool sendfile(const Header &, const int, const std::vector<std::string> & = { }) const;
+    // Non-blocking output: queue() stages data, flush() sends what the
+    // socket admits without waiting, pending() remains
+    virtual bool queue(const std::string_view P) { wbuf += P; return true; }
+    bool flush(void);
+    std::size_t pending(void) const { return wbuf.size() - wpos; }
+  };
+
+  // Process-wide cache of name resolutions keyed by host:port. Callers
+  // asking for the same name share one lookup, in flight or cached until
+  // TTL. Failed and expired lookups are pruned as new ones start.
+  class Resolver {
+  public:
+    struct Addr {
+      int family, socktype, protocol;
+      ::sockaddr_storage addr;
+      ::socklen_t addrlen;
+    };
+    using Addrs = std::vector<Addr>;
+  private:
+    struct Entry {
+      std::shared_future<Addrs> addrs;
+      time_p expiry;
+    };
+    static std::mutex mtx;
+    static std::unordered_map<std::string, Entry> CACHE;
+    static std::atomic<unsigned> ttl;
+    static std::atomic<std::size_t> lookups;
+    static Addrs getaddrinfo(const std::string, const std::string);
+  public:
+    static std::shared_future<Addrs> resolve(const std::string &, const std::string &);
+    // Empty where the lookup fails or remains pending after TOMS
+    static Addrs lookup(const std::string &HOST, const std::string &PORT,
+        const unsigned TOMS = CONNECT_TOMS) {
+      const auto F { resolve(HOST, PORT) };
+      return F.wait_for(std::chrono::milliseconds(TOMS)) == std::future_status::ready ?
+        F.get() : Addrs { }; }
+    static void set_ttl(const unsigned TTLMS) { ttl = TTLMS; }
+    static std::size_t lookupcount(void) { return lookups; }
+    static void clear(void);
+  };
+
+  // TLS handshake progress
+  enum class HS { DONE, WANTR, WANTW, FAIL };
+
+  // Process-wide client TLS session cache keyed by host:port. Holds the
+  // latest sessions (tickets or session IDs) issued by each server.
+  class SessionCache {
+    static constexpr std::size_t MAXN { 8 };
+    static std::mutex mtx;
+    static std::unordered_map<std::string, std::deque<::SSL_SESSION *>> SESS;
+    static std::atomic<std::size_t> hits, misses;
+  public:
+    static ::SSL_SESSION *get(const std::string &);
+    static void put(const std::string &, ::SSL_SESSION *);
+    static void count(const bool HIT) { HIT ? hits++ : misses++; }
+    static std::size_t hitcount(void) { return hits; }
+    static std::size_t misscount(void) { return misses; }
+    static void clear(void);
   };
 
   class Https : public Http {
     ::SSL_CTX *ctx { };
     ::SSL *ssl { };
     ::BIO *r { }, *w { };
+    // kTLS requested, and in effect once established
+    bool optktls { }, ktls { };
+    // SessionCache key
+    std::string sesskey;
+    // ALPN protocol offered, in wire format
+    std::string alpn;
+    static int newsess(::SSL *, ::SSL_SESSION *);
   public:
     Https(void) = default;
     explicit Https(const int FD) : Http { FD } { }
@@ -85,7 +217,9 @@ namespace sockpp {
       return (ctx = ::SSL_CTX_new(::TLS_client_method())); }
     bool init_server(void) {
       return (ctx = ::SSL_CTX_new(::TLS_server_method())); }
-    bool init(void) { return (ssl = ::SSL_new(ctx)); }
+    bool init(void) { return init(ctx); }
+    // Connexion on a shared context, referenced rather than owned
+    bool init(::SSL_CTX *);
     void deinit(void) const;
     bool configure_ctx(const char [], const char []) const;
     ::SSL_CTX *set_ctx(::SSL_CTX *ctx) const {
@@ -94,58 +228,122 @@ namespace sockpp {
     bool init_rbio(void) { return (r = ::BIO_new(::BIO_s_mem())); }
     bool init_wbio(void) { return (w = ::BIO_new(::BIO_s_mem())); }
     void set_rwbio(void) const { ::SSL_set_bio(ssl, r, w); }
+    bool init_rwbio(void);
     void set_connect_state(void) const { ::SSL_set_connect_state(ssl); }
     void set_accept_state(void) const { ::SSL_set_accept_state(ssl); }
     bool set_hostname(const char HOST[]) const {
       return ::SSL_set_tlsext_host_name(ssl, HOST) > -1; }
     bool set_fd(int sockfd) const { return ::SSL_set_fd(ssl, sockfd) > -1; }
-    bool do_handshake(void) const { return ::SSL_do_handshake(ssl) > -1; }
+    bool do_handshake(void) const { return ::SSL_do_handshake(ssl) == 1; }
+    HS handshake(void) const;
     void certinfo(std::string &, std::string &, std::string &) const;
+    void set_ktls(const bool KTLS) override { optktls = KTLS; }
+    bool isktls(void) const { return ktls; }
+    void set_alpn(const std::string_view PROTO) {
+      alpn = static_cast<char>(PROTO.size()) + std::string { PROTO }; }
+    std::string_view protocol(void) const;
     bool connect(const char []) override;
-    void readfilter(char p) override { ::BIO_write(r, &p, sizeof p); }
-    bool postread(char &p) override { 
-      return ::SSL_read(ssl, &p, sizeof p) > 0; }
+    bool fill(const int) override;
+    bool buffered(void) const override {
+      return Http::buffered() || ::SSL_pending(ssl) || (r && ::BIO_ctrl_pending(r)); }
     bool write(const std::string &) const override;
+    bool write(const std::vector<std::string_view> &, const bool = false) const override;
+    bool writemore(const std::string &req) const override { return write(req); }
+    bool sendfile(const int, ::off_t, std::size_t) const override;
+    using Http::sendfile;
+    bool queue(const std::string_view) override;
+    // Server context for CERT and KEY, nullptr on failure
+    static ::SSL_CTX *server_ctx(const char [], const char []);
   };
 
-  class Http2 {
-    // TODO
-  };
- 
   // Mandatory
   using Client_cb = std::function<void(const char)>;
+  using Client_span_cb = std::function<void(const std::string_view)>;
   // Idempotent Client Callback Writer
   static Client_cb const IDCB { [](const char) { } };
+  static Client_span_cb const IDSPANCB { [](const std::string_view) { } };
+  // Request body source, called for each chunk in turn until it returns an
+  // empty span. A span remains valid until the following call.
+  using Client_src_cb = std::function<std::string_view(void)>;
+  // Adapt a per-byte writer to a span writer
+  inline Client_span_cb span_cb(const Client_cb &CB) {
+    return [CB](const std::string_view P) { for (const auto p : P) CB(p); };
+  }
   enum class Meth { GET, POST, PUT, DELETE };
   
   namespace Handle {
+    // File range sent with its Content-Length
+    struct Range {
+      int FD { -1 };
+      ::off_t OFF { };
+      std::size_t LEN { };
+    };
+
+    // Body sent with its Content-Length in place of DATA: a file range, or
+    // memory such as a mapping, referenced rather than copied
+    using Body = std::variant<std::monostate, Range, std::string_view>;
+
+    // At most one of DATA, BODY and SRC, the latter sent chunked
     struct Req {
       const Meth METH { Meth::GET };
       const std::vector<std::string> HEAD;
       const std::string DATA, ENDP { "/" };
+      const Body BODY { };
+      const Client_src_cb SRC { };
+    };
+
+    // Request line and fixed headers, serialised once by Send::prepare.
+    // Each issue appends the headers and data of its own Req.
+    struct Prepared {
+      const Meth METH { Meth::GET };
+      const std::string PREFIX;
     };
     
     class Xfr {
-      std::variant<Req, std::string> vrr;
-      Client_cb cb { IDCB };
+      std::variant<Req, Header> vrr;
+      Client_span_cb cb { IDSPANCB };
     public:
       Xfr(void) = default;
       explicit Xfr(const Req &REQ) : vrr { REQ } { }
       Xfr(const Req &REQ, const Client_cb &CB) :
+        vrr { REQ }, cb { span_cb(CB) } { }
+      Xfr(const Req &REQ, const Client_span_cb &CB) :
         vrr { REQ }, cb { CB } { }
       Req &req(void) { return std::get<Req>(vrr); }
-      void setres(void) { vrr = std::string { }; }
-      std::string &header(void) { return std::get<std::string>(vrr); }
-      Client_cb &writercb(void) { return cb; };
+      void setres(void) { vrr = Header { }; }
+      Header &header(void) { return std::get<Header>(vrr); }
+      Client_span_cb &writercb(void) { return cb; };
     };
   }
 
+  // Resumable response receiver, advanced by spans of the response as
+  // they arrive: the header into the handle, the body to its writer
+  class Response {
+    enum class ST { HDR, BODY, SIZE, DATA, DATAEND, TRAILER, DONE };
+    ST st { ST::HDR };
+    std::size_t l { };
+    bool err { };
+    std::string line;
+    std::size_t feedline(const std::string_view);
+  public:
+    std::size_t feed(Handle::Xfr &, const std::string_view);
+    bool done(void) const { return st == ST::DONE; }
+    bool fail(void) const { return err; }
+  };
+
   template<typename S>
   class Send {
     static std::string AGENT;
     static std::array<std::string, 4> METHSTR;
+    bool send(S &, const Handle::Prepared &, const std::vector<std::string> &,
+      const Handle::Req &) const;
   public:
+    // Message of a Req holding its body in DATA, else empty
+    std::string str(const std::string &, const Handle::Req &) const;
     bool req(S &, const std::string &, const Handle::Req &) const;
+    // METH, ENDP and HEAD of the Req are fixed, its body is ignored
+    Handle::Prepared prepare(const std::string &, const Handle::Req &) const;
+    bool req(S &, const Handle::Prepared &, const Handle::Req &) const;
   };
 
   template<typename S>
@@ -156,66 +354,108 @@ namespace sockpp {
   template class Send<Http>;
   template class Send<Https>;
 
-  struct Regex { 
-    std::regex OK { std::regex("OK", std::regex_constants::icase) },
-      CL { std::regex("Content-Length: ", std::regex_constants::icase) },
-      TE { std::regex("Transfer-Encoding: ", std::regex_constants::icase) },
-      CHKD { std::regex("Chunked", std::regex_constants::icase) },
-      CHKDHDR { std::regex("(0x)?[0-9a-f]+\r\n$", std::regex_constants::icase) };
-  };
-
   template<typename S>
   class Recv {
     const unsigned TOMS { SINGULAR_TOMS };
-    static Regex RGX;
   public:
     Recv(void) = default;
     explicit Recv(const unsigned TOMS) : TOMS { TOMS } { }
     bool ischkd(const std::string &) const;
+    bool reqhdr(S &, Header &) const;
     bool reqhdr(S &, std::string &) const;
     std::size_t parsecl(const std::string &) const;
-    bool reqbody(S &, const Client_cb &, std::size_t) const;
+    bool reqbody(S &, const Client_span_cb &, std::size_t) const;
+    bool reqbody(S &s, const Client_span_cb &CB) const { return reqchkd(s, CB); }
+    bool reqbody(S &s, const Client_cb &CB, std::size_t l) const {
+      return reqbody(s, span_cb(CB), l); }
     bool reqbody(S &s, const Client_cb &CB) const { return reqchkd(s, CB); }
-    bool reqchkd(S &, const Client_cb &) const;
-    void reqchkd_raw(S &, const Client_cb &) const;
+    bool reqchkd(S &, const Client_span_cb &) const;
+    bool reqchkd(S &s, const Client_cb &CB) const {
+      return reqchkd(s, span_cb(CB)); }
+    void reqchkd_raw(S &, const Client_span_cb &) const;
+    void reqchkd_raw(S &s, const Client_cb &CB) const {
+      reqchkd_raw(s, span_cb(CB)); }
   };
 
-  template<typename S>
-  Regex Recv<S>::RGX;
-
   template class Recv<Http>;
   template class Recv<Https>;
+
+  // Response writer on a server connexion. The status line, header and
+  // body are held and leave in one write on flush(), end(), or once they
+  // exceed LIMIT. A chunked body leaves one chunk per write of the buffer.
+  template<typename S>
+  class Reply {
+    static constexpr std::size_t LIMIT { WBN };
+    S &sock;
+    // Header, or the end of the last chunk, up to data, then body data
+    std::string buf;
+    std::size_t data { };
+    bool body { }, chkd { }, err { };
+    bool send(const std::string_view = { }, const bool = false, const bool = false);
+  public:
+    Reply(void) = delete;
+    explicit Reply(S &, const unsigned = 200, const std::string_view = "OK");
+    bool field(const std::string_view, const std::string_view);
+    // End of the header, with the length of the body or else chunked
+    bool length(const std::size_t);
+    bool chunked(void);
+    bool write(const std::string_view);
+    bool sendfile(const int, const ::off_t, const std::size_t);
+    bool flush(void) { return send(); }
+    // Sends the terminating chunk where chunked, an empty body if none begun
+    bool end(void) { return (body || length(0)) && send({ }, true); }
+  };
+
+  template class Reply<Http>;
+  template class Reply<Https>;
   
   template<typename S>
   class Client {
     const std::string HOST;
     S sock;
+    bool response(Handle::Xfr &, const unsigned);
   public:
     Client(void) = delete;
-    Client(const char [], const char []);
+    Client(const char [], const char [], const bool = false, const Sockopts & = { });
     bool performreq(Handle::Xfr &, const unsigned = SINGULAR_TOMS);
+    // Prepared request completed by the HEAD and body of the transfer
+    Handle::Prepared prepare(const Handle::Req &REQ) const {
+      return Send<S> { }.prepare(HOST, REQ); }
+    bool performreq(const Handle::Prepared &, Handle::Xfr &, const unsigned = SINGULAR_TOMS);
+    // Pipelined: requests are written in one batch ahead of the responses
+    bool performreq(const std::vector<std::reference_wrapper<Handle::Xfr>> &,
+      const unsigned = SINGULAR_TOMS);
     void close(void) { sock.Http::deinit(); }
+    S &get_sock(void) { return sock; }
+    const std::string &get_host(void) const { return HOST; }
   };
 
   template class Client<Http>;
   template class Client<Https>;
 
+  // Pool of connexions to one host, sized at runtime. Transfers are queued
+  // and each is issued on the next idle connexion.
   template<typename S>
   class MultiClient {
-    static constexpr std::size_t MAXN { 32 };
-    std::array<S, MAXN> SOCK;
-    std::bitset<MAXN> C;
-    const std::string HOST;
+    const std::string HOST, PORT;
+    const Sockopts OPTS;
+    std::vector<std::unique_ptr<S>> SOCK;  // nullptr where a connexion failed
+    // Transfer in progress on a connexion
     struct SockH {
-      std::reference_wrapper<S> sock;
-      std::reference_wrapper<Handle::Xfr> h;
+      Handle::Xfr *h;
+      Response res;
     };
+    bool connect(std::unique_ptr<S> &);
   public:
     MultiClient(void) = delete;
-    MultiClient(const char [], const char [], const unsigned);
+    MultiClient(const char [], const char [], const unsigned, const Sockopts & = { });
     bool performreq(const std::vector<std::reference_wrapper<Handle::Xfr>> &, 
       const unsigned = SINGULAR_TOMS);
-    std::size_t cnxcount(void) const { return C.count(); }
+    std::size_t reconnect(void);
+    std::size_t cnxcount(void) const {
+      return std::count_if(SOCK.begin(), SOCK.end(),
+        [](const std::unique_ptr<S> &sock) { return sock != nullptr; }); }
+    std::size_t capacity(void) const { return SOCK.size(); }
   };
 
   template class MultiClient<Http>;
@@ -224,20 +464,156 @@ namespace sockpp {
   template<typename S>
   using Server_cb = std::function<bool(S &)>;
   
+  // Idle connexions shared between callers and threads, keyed by host:port.
+  // A connexion returns to the pool after a complete response unless the
+  // server closes it, and leaves once its Keep-Alive timeout expires or it
+  // is the least recently used beyond MAXIDLE.
+  template<typename S>
+  class Pool {
+    struct Idle {
+      std::string key;
+      std::unique_ptr<S> sock;
+      time_p expiry;
+    };
+    const std::size_t MAXIDLE;
+    const unsigned IDLETOMS;
+    std::mutex mtx;
+    std::list<Idle> IDLE;  // Least recently used first
+  public:
+    Pool(const std::size_t = 64, const unsigned = 30000);
+    std::unique_ptr<S> get(const std::string &, const std::string &);
+    void put(const std::string &, const std::string &, std::unique_ptr<S>, const Header &);
+    bool performreq(const std::string &, const std::string &, Handle::Xfr &,
+      const unsigned = SINGULAR_TOMS);
+    std::size_t idlecount(void);
+    void clear(void);
+  };
+
+  template class Pool<Http>;
+  template class Pool<Https>;
+
+  // HTTP/2 client connexion, negotiated with ALPN over TLS or else in
+  // cleartext with prior knowledge (h2c). Transfers are multiplexed as
+  // streams on the one connexion, under the peer's flow control and
+  // concurrency limits.
+  class Http2 {
+    enum : unsigned char { DATA, HEADERS, PRIORITY, RST_STREAM, SETTINGS,
+      PUSH_PROMISE, PING, GOAWAY, WINDOW_UPDATE, CONTINUATION };
+    enum : unsigned char { END_STREAM = 0x1, ACK = 0x1, END_HEADERS = 0x4,
+      PADDED = 0x8, PRIO = 0x20 };
+    enum : std::uint32_t { PROTOCOL_ERROR = 0x1, FRAME_SIZE_ERROR = 0x6, CANCEL = 0x8 };
+    // Receive window, replenished once half consumed
+    static constexpr std::uint32_t WINDOW { 1U << 24 };
+    static constexpr std::uint32_t MAXFRAME { 16384 };
+    struct Stream {
+      Handle::Xfr *h;
+      // Request body, sent as the windows allow
+      std::string data;
+      std::size_t sent { };
+      std::int64_t sendwin;
+      // Received since the last WINDOW_UPDATE
+      std::uint32_t recvd { };
+      bool hdr { }, done { }, fail { };
+    };
+    const std::string HOST;
+    std::unique_ptr<Http> sock;
+    Hpack::Encoder enc;
+    Hpack::Decoder dec;
+    std::string in, out;
+    // Header block in progress over HEADERS and CONTINUATION
+    std::string block;
+    std::uint32_t blockid { };
+    bool blockend { };
+    std::uint32_t nextid { 1 };
+    std::int64_t sendwin { 65535 };
+    std::uint32_t recvd { };
+    // Peer settings
+    std::uint32_t peerwin { 65535 }, peerframe { 16384 }, peerstreams { UINT32_MAX };
+    bool settings { }, goaway { };
+    // Sent with GOAWAY where dispatch fails
+    std::uint32_t error { PROTOCOL_ERROR };
+    std::unordered_map<std::uint32_t, Stream> STREAMS;
+    void frame(const unsigned char, const unsigned char, const std::uint32_t,
+      const std::string_view = { });
+    bool open(Handle::Xfr &);
+    void senddata(const std::uint32_t, Stream &);
+    bool endheaders(void);
+    bool dispatch(const unsigned char, const unsigned char, const std::uint32_t,
+      std::string_view);
+    bool recv(const unsigned);
+  public:
+    Http2(void) = delete;
+    Http2(const char [], const char [], const bool = true);
+    ~Http2(void);
+    bool performreq(const std::vector<std::reference_wrapper<Handle::Xfr>> &,
+      const unsigned = MULTI_TOMS);
+    bool isopen(void) const { return !goaway && !sock->iseof(); }
+  };
+
   template<typename S>
   class Server {
+    static constexpr std::size_t MAXEV { 256 };
     S sock;  // Master
-    std::vector<std::unique_ptr<S>> SOCK;  // Slaves
+    std::unordered_map<int, std::unique_ptr<S>> SOCK;  // Slaves by fd
+    // Accepted connexions pending TLS handshake, queued in accept order
+    struct Pending {
+      std::unique_ptr<S> sock;
+      time_p t;
+    };
+    std::unordered_map<int, Pending> PEND;
+    std::deque<std::pair<int, time_p>> PENDQ;
     std::atomic<bool> quit { };
+    bool ktls { };
+    // Applied to each accepted connexion
+    Sockopts opts;
+    int epfd { -1 };
+    // Server TLS context shared by every connexion, nullptr for Http
+    ::SSL_CTX *ctx { };
+    std::mutex ctxmtx;
+    bool ctl(const int, const int, const unsigned);
+    void insert(std::unique_ptr<S>);
+    void erase(const int);
+    void handshake(const int);
+    void expire(void);
+    void dispatch(const Server_cb<S> &, const int);
   public:
     Server(void) = delete;
-    explicit Server(const char []);
+    explicit Server(const char [], const bool = false,
+      const char [] = CERT, const char [] = KEY);
+    Server(const char [], const Sockopts &, const char [] = CERT, const char [] = KEY);
+    ~Server(void);
     bool poll_listen(const int TOMS) { return sock.pollin(TOMS); }
-    void recv_client(const char [], const char []);
-    void run(const Server_cb<S> &, const char [] = CERT, const char [] = KEY);
+    bool reload(const char [] = CERT, const char [] = KEY);
+    // Request kTLS offload on subsequently accepted connexions
+    void set_ktls(const bool KTLS) { ktls = KTLS; }
+    void recv_client(void);
+    void run(const Server_cb<S> &);
     void exit(void) { quit = true; }
   };
 
   template class Server<Http>;
   template class Server<Https>;
+
+  // Shards connexions across N Servers, each running on its own thread with
+  // its own SO_REUSEPORT listener. The callback is shared by all threads.
+  template<typename S>
+  class MultiServer {
+    std::vector<std::unique_ptr<Server<S>>> SERVER;
+  public:
+    MultiServer(void) = delete;
+    MultiServer(const char [], const unsigned,
+      const char [] = CERT, const char [] = KEY);
+    // Each shard takes OPTS with reuseport
+    MultiServer(const char [], const unsigned, const Sockopts &,
+      const char [] = CERT, const char [] = KEY);
+    void run(const Server_cb<S> &, const bool = false);
+    bool reload(const char [] = CERT, const char [] = KEY);
+    void set_ktls(const bool KTLS) {
+      for (auto &server : SERVER) server->set_ktls(KTLS); }
+    void exit(void) { for (auto &server : SERVER) server->exit(); }
+    std::size_t shardcount(void) const { return SERVER.size(); }
+  };
+
+  template class MultiServer<Http>;
+  template class MultiServer<Https>;
 }
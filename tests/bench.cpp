@@ -0,0 +1,204 @@
+// Loopback benchmark of Client, MultiClient and Server over Http and Https.
+// Servers run in-process, the Https one on a self-signed certificate
+// generated for the run. Each workload runs for the given duration and
+// reports one JSON object per line:
+//   connect    a new connexion per small request
+//   keepalive  small requests on one connexion
+//   large      4 MiB responses on one connexion
+//   chunked    1 MiB responses in 4 KiB chunks on one connexion
+//   multi      batches of small requests over MultiClient connexions
+// Usage: ./bench [ms per workload] [http port] [https port]
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <thread>
+#include <csignal>
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/evp.h>
+#include <libsockpp/sock.h>
+#include <libsockpp/time.h>
+
+static const char HOST[] { "localhost" };
+static const std::size_t SMALL { 16 }, LARGE { 4 << 20 }, CHUNKED { 1 << 20 }, CHUNK { 4 << 10 };
+static const unsigned MULTI_N { 8 };
+
+// Self-signed certificate and key for localhost
+static bool mkcert(const std::string &CERTPATH, const std::string &KEYPATH) {
+  ::EVP_PKEY *pkey { ::EVP_EC_gen("P-256") };
+  ::X509 *x509 { ::X509_new() };
+  bool ok { pkey && x509 };
+  if (ok) {
+    ::X509_set_version(x509, 2);
+    ::ASN1_INTEGER_set(::X509_get_serialNumber(x509), 1);
+    ::X509_gmtime_adj(::X509_getm_notBefore(x509), 0);
+    ::X509_gmtime_adj(::X509_getm_notAfter(x509), 86400);
+    ::X509_set_pubkey(x509, pkey);
+    auto *const NAME { ::X509_get_subject_name(x509) };
+    ::X509_NAME_add_entry_by_txt(NAME, "CN", MBSTRING_ASC,
+      reinterpret_cast<const unsigned char *>(HOST), -1, -1, 0);
+    ::X509_set_issuer_name(x509, NAME);
+    ok = ::X509_sign(x509, pkey, ::EVP_sha256()) > 0;
+  }
+
+  if (FILE *f { ok ? std::fopen(CERTPATH.c_str(), "w") : nullptr }) {
+    ok = ::PEM_write_X509(f, x509);
+    std::fclose(f);
+  } else
+      ok = false;
+  if (FILE *f { ok ? std::fopen(KEYPATH.c_str(), "w") : nullptr }) {
+    ok = ::PEM_write_PrivateKey(f, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+    std::fclose(f);
+  } else
+      ok = false;
+
+  ::X509_free(x509);
+  ::EVP_PKEY_free(pkey);
+  return ok;
+}
+
+template<typename S>
+static bool serve(S &sock) {
+  static const std::string BODY(LARGE, 'x');
+  sockpp::Recv<S> recv { 1000 };
+  sockpp::Header hdr;
+  if (!recv.reqhdr(sock, hdr))
+    return false;
+
+  const auto LINE { hdr.startline() };
+  sockpp::Reply<S> reply { sock };
+  if (LINE.find("/large") != std::string_view::npos)
+    return reply.length(LARGE) && reply.write(BODY) && reply.end();
+  else if (LINE.find("/chunked") != std::string_view::npos) {
+    if (!reply.chunked())
+      return false;
+    // Flushed per write, one chunk each
+    for (std::size_t n { }; n < CHUNKED; n += CHUNK)
+      if (!reply.write(std::string_view { BODY.data(), CHUNK }) || !reply.flush())
+        return false;
+    return reply.end();
+  }
+
+  return reply.length(SMALL) && reply.write(std::string_view { BODY.data(), SMALL }) &&
+    reply.end();
+}
+
+struct Result {
+  std::size_t requests { }, errors { }, bytes { };
+  std::vector<std::size_t> ns;
+};
+
+// Latency at quantile Q of the sorted samples
+static double quantile(const std::vector<std::size_t> &NS, const double Q) {
+  if (NS.empty())
+    return 0;
+  const auto I { static_cast<std::size_t>(std::ceil(Q * NS.size())) };
+  return NS[std::min(NS.size() - 1, I ? I - 1 : 0)] / 1000.0;
+}
+
+static void report(const char PROTO[], const char WORKLOAD[], Result &r, const std::size_t NS) {
+  std::sort(r.ns.begin(), r.ns.end());
+  const double SECS { NS / 1e9 };
+  std::cout << std::fixed << std::setprecision(3)
+    << "{\"proto\":\"" << PROTO << "\",\"workload\":\"" << WORKLOAD
+    << "\",\"requests\":" << r.requests << ",\"errors\":" << r.errors
+    << ",\"seconds\":" << SECS << ",\"rps\":" << r.requests / SECS
+    << ",\"p50_us\":" << quantile(r.ns, 0.5) << ",\"p99_us\":" << quantile(r.ns, 0.99)
+    << ",\"p999_us\":" << quantile(r.ns, 0.999)
+    << ",\"mb_per_s\":" << r.bytes / SECS / (1 << 20) << "}" << std::endl;
+}
+
+// Runs OP until MS elapse, timing each call. OP returns the transfers it
+// completed, 0 on error, and adds the body bytes received.
+template<typename OP>
+static void run(const char PROTO[], const char WORKLOAD[], const std::size_t MS, OP op) {
+  sockpp::Time time;
+  Result r;
+  const auto INITTIME { time.now() };
+  std::size_t elapsed { };
+  while ((elapsed = time.diffpt<std::chrono::nanoseconds>(time.now(), INITTIME)) < MS * 1000000) {
+    const auto T0 { time.now() };
+    if (const auto N { op(r.bytes) }; N) {
+      r.ns.push_back(time.diffpt<std::chrono::nanoseconds>(time.now(), T0));
+      r.requests += N;
+    } else
+        r.errors++;
+  }
+
+  report(PROTO, WORKLOAD, r, elapsed);
+}
+
+template<typename S>
+static void bench(const char PROTO[], const char PORT[], const std::size_t MS) {
+  const auto get {
+    [](auto &client, const char ENDP[], std::size_t &bytes) -> std::size_t {
+      sockpp::Handle::Xfr h { { sockpp::Meth::GET, { }, { }, ENDP },
+        sockpp::Client_span_cb { [&bytes](const std::string_view P) { bytes += P.size(); } } };
+      return client.performreq(h);
+    }
+  };
+
+  run(PROTO, "connect", MS, [&](std::size_t &bytes) -> std::size_t {
+    try {
+      sockpp::Client<S> client { HOST, PORT };
+      return get(client, "/small", bytes);
+    } catch (const std::exception &) { return 0; }
+  });
+
+  sockpp::Client<S> client { HOST, PORT };
+  run(PROTO, "keepalive", MS, [&](std::size_t &bytes) { return get(client, "/small", bytes); });
+  run(PROTO, "large", MS, [&](std::size_t &bytes) { return get(client, "/large", bytes); });
+  run(PROTO, "chunked", MS, [&](std::size_t &bytes) { return get(client, "/chunked", bytes); });
+
+  sockpp::MultiClient<S> multi { HOST, PORT, MULTI_N };
+  run(PROTO, "multi", MS, [&](std::size_t &bytes) -> std::size_t {
+    std::vector<sockpp::Handle::Xfr> X;
+    X.reserve(MULTI_N);
+    for (auto i { 0U }; i < MULTI_N; i++)
+      X.emplace_back(sockpp::Handle::Req { sockpp::Meth::GET, { }, { }, "/small" },
+        sockpp::Client_span_cb { [&bytes](const std::string_view P) { bytes += P.size(); } });
+    return multi.performreq({ X.begin(), X.end() }) ? MULTI_N : 0;
+  });
+}
+
+int main(const int ARGC, const char *ARGV[]) {
+  signal(SIGPIPE, SIG_IGN);
+  const std::size_t MS { ARGC > 1 ? std::stoul(ARGV[1]) : 2000 };
+  const char *const PORT { ARGC > 2 ? ARGV[2] : "8090" };
+  const char *const SSLPORT { ARGC > 3 ? ARGV[3] : "4490" };
+  char dir[] { "/tmp/sockppbenchXXXXXX" };
+  if (!::mkdtemp(dir)) {
+    std::cerr << "Unable to create certificate directory\n";
+    return 1;
+  }
+
+  const std::string CERTPATH { std::string { dir } + "/cert.pem" },
+    KEYPATH { std::string { dir } + "/key.pem" };
+  int status { };
+  try {
+    if (!mkcert(CERTPATH, KEYPATH))
+      throw std::runtime_error("Unable to generate certificate");
+    sockpp::Server<sockpp::Http> server { PORT };
+    sockpp::Server<sockpp::Https> sslserver { SSLPORT, false, CERTPATH.c_str(), KEYPATH.c_str() };
+    std::thread th { [&server](void) { server.run(serve<sockpp::Http>); } },
+      sslth { [&sslserver](void) { sslserver.run(serve<sockpp::Https>); } };
+    bench<sockpp::Http>("http", PORT, MS);
+    bench<sockpp::Https>("https", SSLPORT, MS);
+    server.exit();
+    sslserver.exit();
+    th.join();
+    sslth.join();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    status = 1;
+  }
+
+  std::remove(CERTPATH.c_str());
+  std::remove(KEYPATH.c_str());
+  ::rmdir(dir);
+  return status;
+}
@@ -26,23 +26,21 @@ int main(const int ARGC, const char *ARGV[]) {
       std::cout << "-Receive from client-\n";
       std::cout << cli_head << "\n";
       std::cout << "-End receive from client-\n";
-      const std::string header {
-        std::string("Transfer-Encoding: chunked\r\n") + "\r\n" };
-      if (!sock.write(header))
-        return false;
+      sockpp::Reply<sockpp::Https> reply { sock };
+      reply.chunked();
       sockpp::Time time;
       auto now { time.now() };
       while (time.diffpt<std::chrono::milliseconds>(time.now(), now) < 2000) {
         auto s { std::to_string(pow(2, sockpp::rand(8, 32))) };
-        std::string document { sockpp::to_base16(s.size() + 2) + "\r\n" + s + "\r\n" };
-        if (!sock.write(document))
+        // Each flush sends what is held as one chunk
+        if (!reply.write(s + "\r\n") || !reply.flush())
           return false;
         std::cout << "Sent to client " << s << std::endl;
         now = time.now();
         std::this_thread::sleep_for(std::chrono::milliseconds(sockpp::rand(500, 2000)));
       }
-      // Blocks at the server end subject to timeout
-      return true;
+      // Terminating chunk
+      return reply.end();
     } 
   };
 
@@ -13,7 +13,9 @@ int main(int ARGC, char *ARGV[]) {
     host = std::string(ARGV[1]);
 
   // Chunked transfer
-  sockpp::Client_cb writer_cb { [](const char p) { std::cout << p; } };
+  sockpp::Client_span_cb writer_cb {
+    [](const std::string_view P) { std::cout.write(P.data(), P.size()); }
+  };
   sockpp::Handle::Xfr h { { sockpp::Meth::GET, { }, { }, "/" }, writer_cb };
   try {
     sockpp::Client<sockpp::Http> client { host.c_str(), PORT };
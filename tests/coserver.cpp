@@ -0,0 +1,30 @@
+// Example demonstrates a coroutine server. Every connexion is a coroutine
+// on the one reactor thread, suspended while its socket would block, so
+// no thread is held per connexion. Built as C++20.
+
+#include <iostream>
+#include <csignal>
+#include <libsockpp/coro.h>
+
+static const char PORT[] { "8080" };
+
+int main(const int ARGC, const char *ARGV[]) {
+  signal(SIGPIPE, SIG_IGN);
+  try {
+    sockpp::Reactor reactor;
+    sockpp::CoServer<sockpp::Http> server { reactor, PORT };
+    std::cout << "Running coroutine HTTP server...\n";
+    server.run([&reactor](sockpp::Http &sock) -> sockpp::Task<bool> {
+      sockpp::Header hdr;
+      if (const bool OK { co_await sockpp::Async::reqhdr(reactor, sock, hdr) }; !OK)
+        co_return false;
+      else if (const bool OK { co_await sockpp::Async::reqbody(reactor, sock, sockpp::IDSPANCB,
+          hdr.contentlen()) }; !OK)
+        co_return false;
+      const std::string document { "Document\r\n" };
+      co_return co_await sockpp::Async::write(reactor, sock,
+        "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(document.size()) + "\r\n\r\n" + document);
+    });
+  } catch (const std::exception &e) { std::cerr << e.what() << std::endl; }
+  return 0;
+}
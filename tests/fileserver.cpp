@@ -0,0 +1,43 @@
+// Example demonstrates serving a static file. The library sends the
+// file (or the byte range requested) from the descriptor, without
+// reading it into userspace on plain connexions.
+
+#include <iostream>
+#include <csignal>
+#include <fcntl.h>
+#include <libsockpp/sock.h>
+
+static const char PORT[] { "8080" };
+
+int main(const int ARGC, const char *ARGV[]) {
+  signal(SIGPIPE, SIG_IGN);
+  if (ARGC != 2) {
+    std::cerr << "Usage: ./fileserver <file>\n";
+    return 1;
+  }
+
+  const auto FD { ::open(ARGV[1], O_RDONLY) };
+  if (FD < 0) {
+    std::cerr << "Unable to open " << ARGV[1] << std::endl;
+    return 1;
+  }
+
+  auto cb {
+    [&](sockpp::Http &sock) -> bool {
+      sockpp::Recv<sockpp::Http> recv { 1000 };
+      sockpp::Header cli_head;
+      if (!recv.reqhdr(sock, cli_head))
+        return false;
+      std::cout << cli_head.startline() << std::endl;
+      return sock.sendfile(cli_head, FD, { "Content-Type: application/octet-stream" });
+    }
+  };
+
+  try {
+    sockpp::Server<sockpp::Http> server { PORT };
+    std::cout << "Running file server...\n";
+    server.run(cb);
+  } catch (const std::exception &e) { std::cerr << e.what() << std::endl; }
+  ::close(FD);
+  return 0;
+}
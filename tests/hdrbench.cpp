@@ -0,0 +1,63 @@
+// Microbenchmark compares the header parser against the former
+// std::regex path of Recv<S>::ischkd() and Recv<S>::parsecl().
+
+#include <iostream>
+#include <regex>
+#include <libsockpp/header.h>
+#include <libsockpp/time.h>
+
+static const std::string HDR {
+  "HTTP/1.1 200 OK\r\n"
+  "Date: Mon, 27 Jul 2009 12:28:53 GMT\r\n"
+  "Server: Apache/2.2.14 (Win32)\r\n"
+  "Last-Modified: Wed, 22 Jul 2009 19:15:56 GMT\r\n"
+  "Set-Cookie: session=8f2d1c3b4a5e6f708192a3b4c5d6e7f8; Path=/; HttpOnly\r\n"
+  "Set-Cookie: prefs=lang%3Den%26theme%3Ddark%26tz%3DEurope%2FLondon; Path=/\r\n"
+  "Cache-Control: no-cache, no-store, must-revalidate\r\n"
+  "Content-Type: text/html; charset=utf-8\r\n"
+  "Connection: keep-alive\r\n"
+  "Transfer-Encoding: chunked\r\n"
+  "Content-Length: 88\r\n"
+  "\r\n"
+};
+
+static const std::size_t N { 100000 };
+
+int main(const int ARGC, const char *ARGV[]) {
+  const std::regex CL { std::regex("Content-Length: ", std::regex_constants::icase) },
+    TE { std::regex("Transfer-Encoding: ", std::regex_constants::icase) },
+    CHKD { std::regex("Chunked", std::regex_constants::icase) };
+  sockpp::Time time;
+  std::size_t sum { };
+
+  auto now { time.now() };
+  for (auto i { 0U }; i < N; i++) {
+    std::smatch match { };
+    sum += std::regex_search(HDR, match, TE) &&
+      std::regex_match(HDR.substr(match.prefix().length() + 19, 7), CHKD);
+    if (std::regex_search(HDR, match, CL))
+      sum += std::stoull(HDR.substr(match.prefix().length() + 16,
+        HDR.substr(match.prefix().length() + 16).find("\r\n")));
+  }
+
+  const auto REGEX_US { time.diffpt<std::chrono::microseconds>(time.now(), now) };
+  const auto REGEX_SUM { sum };
+  sum = 0;
+  now = time.now();
+  for (auto i { 0U }; i < N; i++) {
+    const sockpp::Header header { HDR };
+    sum += header.ischkd();
+    sum += header.contentlen();
+  }
+
+  const auto PARSER_US { time.diffpt<std::chrono::microseconds>(time.now(), now) };
+  if (sum != REGEX_SUM) {
+    std::cerr << "Result mismatch\n";
+    return 1;
+  }
+
+  std::cout << "regex: " << 1000.0 * REGEX_US / N << " ns/header\n";
+  std::cout << "parser: " << 1000.0 * PARSER_US / N << " ns/header\n";
+  std::cout << "speedup: " << static_cast<double>(REGEX_US) / PARSER_US << "x\n";
+  return 0;
+}
@@ -0,0 +1,32 @@
+// Example demonstrates transfers multiplexed as streams on one HTTP/2
+// connexion, negotiated over TLS with ALPN.
+
+#include <iostream>
+#include <libsockpp/sock.h>
+
+static const char HOST[] { "localhost" };
+static const char PORT[] { "8443" };
+
+int main(const int ARGC, const char *ARGV[]) {
+  sockpp::Client_span_cb gen_writer {
+    [](const std::string_view P) { std::cout << P; }
+  };
+
+  sockpp::Handle::Xfr h0 { { sockpp::Meth::GET, { }, { }, "/" }, gen_writer };
+  sockpp::Handle::Xfr h1 { { sockpp::Meth::GET, { }, { }, "/" }, gen_writer };
+  sockpp::Handle::Xfr h2 { { sockpp::Meth::GET, { }, { }, "/" }, gen_writer };
+  sockpp::Handle::Xfr h3 { { sockpp::Meth::GET, { }, { }, "/" }, gen_writer };
+  try {
+    sockpp::Http2 client { HOST, PORT };
+    std::vector<std::reference_wrapper<sockpp::Handle::Xfr>> H { h0, h1, h2, h3 };
+    if (!client.performreq(H))
+      throw std::runtime_error("Unable to performreq()");
+    std::cout << "All transfer(s) completed\n";
+    for (auto i { 0U }; i < H.size(); i++) {
+      std::cout << "(Stream" << i << "):\n===================\n";
+      std::cout << "The response header:\n===================\n";
+      std::cout << H[i].get().header() << std::endl;
+    }
+  } catch (const std::exception &e) { std::cerr << e.what() << std::endl; }
+  return 0;
+}
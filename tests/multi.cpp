@@ -15,7 +15,8 @@ int main(int ARGC, char *ARGV[]) {
   sockpp::Handle::Xfr h2 { { sockpp::Meth::GET, { }, { }, "/" }, gen_writer };
   sockpp::Handle::Xfr h3 { { sockpp::Meth::GET, { }, { }, "/" }, gen_writer };
   try {
-    sockpp::MultiClient<sockpp::Http> mc { 1.1, HOST1, PORT, 4 };
+    // Four transfers queued over two connexions
+    sockpp::MultiClient<sockpp::Http> mc { HOST1, PORT, 2 };
     std::vector<std::reference_wrapper<sockpp::Handle::Xfr>> H { h0, h1, h2, h3 };
     mc.performreq(H, 2000);
     std::cout << "All transfer(s) completed\n";
@@ -0,0 +1,38 @@
+// Example demonstrates a sharded server. Each shard runs on its own
+// thread with its own listener on the same port, the kernel spreads
+// incoming connexions across them. The callback is shared by all
+// shards and so must be safe to call concurrently.
+
+#include <iostream>
+#include <csignal>
+#include <thread>
+#include <libsockpp/sock.h>
+
+static const char PORT[] { "8080" };
+
+int main(const int ARGC, const char *ARGV[]) {
+  signal(SIGPIPE, SIG_IGN);
+  auto cb {
+    [](sockpp::Http &sock) -> bool {
+      sockpp::Recv<sockpp::Http> recv { 1000 };
+      std::string cli_head;
+      if (!recv.reqhdr(sock, cli_head))
+        return false;
+      recv.reqbody(sock, sockpp::IDCB, recv.parsecl(cli_head));
+      const std::string document { "Document\r\n" };
+      const std::string header {
+        "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(document.size()) + "\r\n\r\n"
+      };
+
+      return sock.write(header + document);
+    }
+  };
+
+  try {
+    sockpp::MultiServer<sockpp::Http> server { PORT, std::thread::hardware_concurrency() };
+    std::cout << "Running HTTP server on " << server.shardcount() << " shard(s)...\n";
+    // Pin each shard to a CPU
+    server.run(cb, true);
+  } catch (const std::exception &e) { std::cerr << e.what() << std::endl; }
+  return 0;
+}
@@ -0,0 +1,29 @@
+// Example demonstrates a connexion pool shared by several threads. Each
+// request borrows an idle connexion to the host, or opens one, and hands
+// it back once the response is complete.
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <libsockpp/sock.h>
+
+static const std::string HOST { "localhost" };
+static const std::string PORT { "8080" };
+
+int main(const int ARGC, const char *ARGV[]) {
+  sockpp::Pool<sockpp::Http> pool { 4 };
+  std::vector<std::thread> T;
+  for (auto i { 0 }; i < 4; i++)
+    T.emplace_back([&pool, i] {
+      for (auto j { 0 }; j < 10; j++) {
+        sockpp::Handle::Xfr h { { sockpp::Meth::GET, { }, { } } };
+        if (!pool.performreq(HOST, PORT, h))
+          std::cerr << "Thread " << i << ": unable to performreq()\n";
+      }
+    });
+
+  for (auto &t : T)
+    t.join();
+  std::cout << "Idle connexion(s) pooled: " << pool.idlecount() << std::endl;
+  return 0;
+}
@@ -23,6 +23,21 @@ int main(const int ARGC, const char *ARGV[]) {
       // Reuse client connexion
       std::this_thread::sleep_for(std::chrono::seconds(1));
     }
+
+    // Pipeline a batch of requests on the same connexion
+    sockpp::Handle::Xfr h0 { { sockpp::Meth::GET, { }, { } }, writer_cb };
+    sockpp::Handle::Xfr h1 { { sockpp::Meth::GET, { }, { } }, writer_cb };
+    sockpp::Handle::Xfr h2 { { sockpp::Meth::GET, { }, { } }, writer_cb };
+    if (!client.performreq({ h0, h1, h2 }))
+      throw std::runtime_error("Unable to performreq() pipelined");
+
+    // Reissue a request prepared once, each issue adding its own data
+    const auto PREPARED { client.prepare({ sockpp::Meth::POST, { "Content-Type: text/plain" } }) };
+    for (auto i { 0 }; i < 10; i++) {
+      sockpp::Handle::Xfr hp { { sockpp::Meth::POST, { }, std::to_string(i) }, writer_cb };
+      if (!client.performreq(PREPARED, hp))
+        throw std::runtime_error("Unable to performreq() prepared");
+    }
   } catch (const std::exception &e) { std::cerr << e.what() << std::endl; }
   return 0;
 }
@@ -0,0 +1,121 @@
+// Example verifies each socket option in turn. The options are applied to
+// a listener, a client connexion and the connexion the server accepts,
+// then read back from the kernel. The backlog is verified by connecting
+// more clients than the former fixed queue of 16 admitted.
+
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <csignal>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <libsockpp/sock.h>
+
+static const char HOST[] { "localhost" };
+static const char ADDR[] { "127.0.0.1" };
+static const char PORT[] { "8080" };
+static const char LISTENPORT[] { "8081" };
+
+static unsigned failed { };
+
+static int getopt(const int FD, const int LEVEL, const int OPT) {
+  int v { -1 };
+  ::socklen_t len { sizeof v };
+  ::getsockopt(FD, LEVEL, OPT, &v, &len);
+  return v;
+}
+
+static void check(const char NAME[], const bool OK) {
+  std::cout << NAME << (OK ? " ok\n" : " FAIL\n");
+  failed += !OK;
+}
+
+int main(const int ARGC, const char *ARGV[]) {
+  signal(SIGPIPE, SIG_IGN);
+  sockpp::Sockopts opts;
+  opts.nodelay = true;
+  opts.quickack = true;
+  opts.rcvbuf = 1 << 18;
+  opts.sndbuf = 1 << 18;
+  opts.busypoll = 50;
+  opts.fastopen = 16;
+  opts.deferaccept = 1;
+  opts.reuseport = true;
+  try {
+    {
+      sockpp::Http listener;
+      if (!listener.init_server(LISTENPORT, opts))
+        throw std::runtime_error("Unable to init listener");
+      const auto FD { listener.get_fd() };
+      check("listener SO_REUSEADDR", getopt(FD, SOL_SOCKET, SO_REUSEADDR) == 1);
+      check("listener SO_REUSEPORT", getopt(FD, SOL_SOCKET, SO_REUSEPORT) == 1);
+      check("listener TCP_FASTOPEN", getopt(FD, IPPROTO_TCP, TCP_FASTOPEN) == opts.fastopen);
+      check("listener TCP_DEFER_ACCEPT", getopt(FD, IPPROTO_TCP, TCP_DEFER_ACCEPT) > 0);
+      // The kernel doubles the size requested
+      check("listener SO_RCVBUF", getopt(FD, SOL_SOCKET, SO_RCVBUF) >= opts.rcvbuf);
+    }
+
+    {
+      // Connexions beyond the backlog have their SYN dropped, none accepted
+      const unsigned N { 48 };
+      sockpp::Sockopts listenopts;
+      listenopts.backlog = 64;
+      sockpp::Http listener;
+      if (!listener.init_server(LISTENPORT, listenopts))
+        throw std::runtime_error("Unable to init listener");
+      std::vector<std::thread> T;
+      std::atomic<unsigned> connected { };
+      sockpp::Sockopts clientopts;
+      clientopts.connect_toms = 500;
+      for (auto i { 0U }; i < N; i++)
+        T.emplace_back([&connected, &clientopts](void) {
+          sockpp::Http client;
+          connected += client.init_client(HOST, LISTENPORT, clientopts);
+          std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        });
+      for (auto &t : T)
+        t.join();
+      check("listener backlog", connected == N);
+    }
+
+    std::atomic<int> accepted_nodelay { -1 }, accepted_rcvbuf { -1 };
+    sockpp::Server<sockpp::Http> server { PORT, opts };
+    std::thread th {
+      [&](void) {
+        server.run([&](sockpp::Http &sock) -> bool {
+          accepted_nodelay = getopt(sock.get_fd(), IPPROTO_TCP, TCP_NODELAY);
+          accepted_rcvbuf = getopt(sock.get_fd(), SOL_SOCKET, SO_RCVBUF);
+          sockpp::Recv<sockpp::Http> recv { 1000 };
+          sockpp::Header hdr;
+          if (!recv.reqhdr(sock, hdr))
+            return false;
+          sockpp::Reply<sockpp::Http> reply { sock };
+          return reply.end();
+        });
+      }
+    };
+
+    // TCP_FASTOPEN_CONNECT is set only where a single address is connected
+    sockpp::Client<sockpp::Http> client { ADDR, PORT, false, opts };
+    const auto FD { client.get_sock().get_fd() };
+    check("client TCP_NODELAY", getopt(FD, IPPROTO_TCP, TCP_NODELAY) == 1);
+    check("client TCP_QUICKACK", getopt(FD, IPPROTO_TCP, TCP_QUICKACK) == 1);
+    check("client SO_RCVBUF", getopt(FD, SOL_SOCKET, SO_RCVBUF) >= opts.rcvbuf);
+    check("client SO_SNDBUF", getopt(FD, SOL_SOCKET, SO_SNDBUF) >= opts.sndbuf);
+    check("client SO_BUSY_POLL", getopt(FD, SOL_SOCKET, SO_BUSY_POLL) == opts.busypoll);
+    check("client TCP_FASTOPEN_CONNECT", getopt(FD, IPPROTO_TCP, TCP_FASTOPEN_CONNECT) == 1);
+    sockpp::Handle::Xfr h { { } };
+    client.performreq(h);
+    check("server TCP_NODELAY", accepted_nodelay == 1);
+    check("server SO_RCVBUF", accepted_rcvbuf >= opts.rcvbuf);
+    sockpp::MultiClient<sockpp::Http> multi { HOST, PORT, 2, opts };
+    check("multiclient connect", multi.cnxcount() == 2);
+    server.exit();
+    th.join();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return failed ? 1 : 0;
+}
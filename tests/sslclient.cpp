@@ -14,8 +14,8 @@ int main(int ARGC, char *ARGV[]) {
     endp = std::string(ARGV[3]);
   }
 
-  sockpp::Client_cb writer_cb {
-    [&](const char p) { std::cout << p; }
+  sockpp::Client_span_cb writer_cb {
+    [](const std::string_view P) { std::cout.write(P.data(), P.size()); }
   };
   
   sockpp::Handle::Xfr h { 
@@ -29,29 +29,21 @@ int main(int ARGC, char *ARGV[]) {
   auto cb { 
     [&](sockpp::Https &sock) -> bool {
       client_msg(sock);
-      const std::string document { "Document" }, 
-            header { 
-                std::string("Content-Length: ") + 
-                  std::to_string(document.size()) + 
-                    std::string("\r\n") +
-                      "\r\n" };
-      return sock.write(header + document) ? true : false;
+      const std::string document { "Document" };
+      sockpp::Reply<sockpp::Https> reply { sock };
+      return reply.length(document.size()) && reply.write(document) && reply.end();
     }
   };
 
   auto chunked_cb { 
     [&](sockpp::Https &sock) -> bool {
       client_msg(sock);
-      const std::string header { 
-          std::string("Transfer-Encoding: chunked\r\n") + "\r\n" };
-      if (!sock.write(header))
-        return false;
-      std::string document;
+      sockpp::Reply<sockpp::Https> reply { sock };
+      reply.chunked();
       while (1) {
         auto s { std::to_string(pow(2, sockpp::rand(8, 32))) };
         std::cout << s << std::endl;
-        document = sockpp::to_base16(s.size() + 2) + "\r\n" + s + "\r\n";
-        if (!sock.write(document))
+        if (!reply.write(s + "\r\n") || !reply.flush())
           return false;
         std::this_thread::sleep_for(std::chrono::milliseconds(sockpp::rand(500, 2000)));
       }
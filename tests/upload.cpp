@@ -0,0 +1,48 @@
+// Example demonstrates streamed request bodies. A file is sent as a
+// range with its Content-Length, then standard input is sent chunked
+// as it is read. Neither is held in memory in full.
+
+#include <iostream>
+#include <fcntl.h>
+#include <libsockpp/sock.h>
+
+static const char HOST[] { "localhost" };
+static const char PORT[] { "8080" };
+
+int main(const int ARGC, const char *ARGV[]) {
+  if (ARGC != 2) {
+    std::cerr << "Usage: ./upload <file>\n";
+    return 1;
+  }
+
+  const int FD { ::open(ARGV[1], O_RDONLY) };
+  if (FD < 0) {
+    std::cerr << "Unable to open " << ARGV[1] << std::endl;
+    return 1;
+  }
+
+  sockpp::Client_span_cb writer_cb {
+    [](const std::string_view P) { std::cout.write(P.data(), P.size()); }
+  };
+  try {
+    sockpp::Client<sockpp::Http> client { HOST, PORT };
+    const std::size_t L = ::lseek(FD, 0, SEEK_END);
+    sockpp::Handle::Xfr h0 { { sockpp::Meth::PUT, { }, { }, "/file", sockpp::Handle::Range { FD, 0, L } },
+      writer_cb };
+    if (!client.performreq(h0))
+      throw std::runtime_error("Unable to performreq() file");
+
+    char buffer[16384];
+    sockpp::Client_src_cb stdin_src {
+      [&buffer](void) -> std::string_view {
+        std::cin.read(buffer, sizeof buffer);
+        return { buffer, static_cast<std::size_t>(std::cin.gcount()) };
+      }
+    };
+    sockpp::Handle::Xfr h1 { { sockpp::Meth::POST, { }, { }, "/stdin", { }, stdin_src }, writer_cb };
+    if (!client.performreq(h1))
+      throw std::runtime_error("Unable to performreq() stdin");
+  } catch (const std::exception &e) { std::cerr << e.what() << std::endl; }
+  ::close(FD);
+  return 0;
+}
@@ -1,5 +1,5 @@
 #include <random>
-#include <sstream>
+#include <charconv>
 #include "utils.h"
 
 int sockpp::rand(std::size_t a, std::size_t b) {
@@ -10,7 +10,6 @@ int sockpp::rand(std::size_t a, std::size_t b) {
 }
 
 std::string sockpp::to_base16(std::size_t arg) {
-  std::stringstream stream;
-  stream << std::hex << arg;
-  return "0x" + stream.str();
+  char hex[2 * sizeof arg];
+  return "0x" + std::string(hex, std::to_chars(hex, hex + sizeof hex, arg, 16).ptr);
 }